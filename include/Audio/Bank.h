@@ -0,0 +1,79 @@
+#ifndef _BANK_H_
+#define _BANK_H_
+
+#include "EstTypes.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+// Build a sound bank, one file holding many sounds behind an index
+// Note: EST_BANK_DECODED stores every sound as f32 PCM, resampled and remixed when sampleRate or channels is set.
+//       Pass the device sample rate and channel count to play the bank without any conversion.
+// Params:
+// entries - The sounds to store [see est_bank_entry]
+// count - The number of entries
+// sampleRate - The sample rate of decoded sounds, 0 keeps the rate of each file
+// channels - The channel count of decoded sounds, 0 keeps the channels of each file
+// flags - How the sounds are stored [see EST_BANK_FLAGS]
+// output - The path of the bank file to write
+// Returns:
+// EST_OK - The bank was built successfully
+// EST_OUT_OF_MEMORY - The bank failed to build due to lack of memory
+// EST_INVALID_ARGUMENT - The bank failed to build due to invalid arguments, unreadable files or duplicated names
+// EST_INVALID_OPERATION - The bank failed to build because the output could not be written
+EST_API enum EST_RESULT EST_BankBuild(const est_bank_entry *entries, int count, int sampleRate, int channels, enum EST_BANK_FLAGS flags, const char *output);
+
+// Open a sound bank, the file is mapped once and only its index is read
+// Params:
+// path - The path to the bank file
+// flags - The mapping flags [see EST_MAP_FLAGS]
+// bank - The handle to the bank
+// Returns:
+// EST_OK - The bank was opened successfully
+// EST_OUT_OF_MEMORY - The bank failed to open due to lack of memory
+// EST_INVALID_ARGUMENT - The bank failed to open due to invalid arguments
+// EST_INVALID_FORMAT - The file is not a sound bank
+// EST_INVALID_STATE - The bank failed to open due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_BankOpen(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_MAP_FLAGS flags, EST_BANK_HANDLE *bank);
+
+// Get the number of sounds in a bank
+// Params:
+// bank - The handle to the bank
+// count - The number of sounds
+// Returns:
+// EST_OK - The count was retrieved successfully
+// EST_INVALID_ARGUMENT - The count failed to retrieve due to invalid arguments
+EST_API enum EST_RESULT EST_BankGetCount(EST_BANK_HANDLE bank, int *count);
+
+// Create samples from a bank in one call
+// Note: Decoded sounds play from the mapped bank, the bank file stays mapped until its last sample is freed.
+//       Samples get the loop region stored in the bank, looping itself is still off.
+// Params:
+// bank - The handle to the bank
+// names - The names of the sounds, as given when the bank was built
+// count - The number of names
+// handles - Receives one sample handle per name
+// Returns:
+// EST_OK - Every sample was created successfully
+// EST_OUT_OF_MEMORY - The samples failed to create due to lack of memory
+// EST_INVALID_ARGUMENT - A name is not in the bank or its sound is invalid, no sample is created
+// EST_INVALID_STATE - The samples failed to create due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_BankLoadSamples(EST_DEVICE_HANDLE device_handle, EST_BANK_HANDLE bank, const char **names, int count, EST_AUDIO_HANDLE *handles);
+
+// Create one sample from a bank [see EST_BankLoadSamples]
+EST_API enum EST_RESULT EST_BankLoadSample(EST_DEVICE_HANDLE device_handle, EST_BANK_HANDLE bank, const char *name, EST_AUDIO_HANDLE *handle);
+
+// Close a bank, samples created from it keep playing
+// Params:
+// bank - The handle to the bank
+// Returns:
+// EST_OK - The bank was closed successfully
+// EST_INVALID_ARGUMENT - The bank failed to close due to invalid arguments
+EST_API enum EST_RESULT EST_BankFree(EST_BANK_HANDLE bank);
+
+#if __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
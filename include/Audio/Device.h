@@ -21,6 +21,41 @@ EST_API enum EST_RESULT EST_DeviceInit(int sampleRate, enum EST_DEVICE_FLAGS fla
 
 EST_API enum EST_RESULT EST_GetInfo(EST_DEVICE_HANDLE device_handle, est_device_info *info);
 
+// Enable the persistent cache of decoded audio files
+// Note: EST_SampleLoadDecoded stores every decoded file at the device rate and channel count,
+//       later EST_SampleLoad and EST_SampleLoadDecoded calls map the stored frames instead of decoding.
+//       Entries are keyed by path, size, modification time and a hash of the file contents.
+// Params:
+// path - The directory to keep the cache in, created on demand (nullptr disables caching)
+// Returns:
+// EST_OK - The cache directory was set successfully
+// EST_OUT_OF_MEMORY - The cache directory failed to set due to lack of memory
+// EST_INVALID_STATE - The cache directory failed to set due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_DeviceSetCacheDirectory(EST_DEVICE_HANDLE device_handle, const char *path);
+
+// Share decoded sounds between every handle loaded from the same source
+// Note: Covers EST_SampleLoadDecoded (keyed by path, size and modification time), EST_SampleLoadMemoryDecoded
+//       and EST_SampleLoadRawPCM (keyed by a hash of the data). Sounds in use always stay shared, unused ones
+//       are kept until the cache exceeds the budget and then evicted least recently used first.
+//       Disabled by default, disabling drops every unused sound.
+// Params:
+// enabled - Whether loads go through the cache
+// budget - The bytes the cache may hold, 0 keeps only sounds in use
+// Returns:
+// EST_OK - The cache was configured successfully
+// EST_INVALID_ARGUMENT - The cache failed to configure due to invalid arguments
+// EST_INVALID_STATE - The cache failed to configure due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_DeviceSetSampleCache(EST_DEVICE_HANDLE device_handle, enum EST_BOOL enabled, long long budget);
+
+// Get the usage of the sample cache
+// Params:
+// stats - Receives the cache usage [see est_sample_cache_stats]
+// Returns:
+// EST_OK - The stats were retrieved successfully
+// EST_INVALID_ARGUMENT - The stats failed to retrieve due to invalid arguments
+// EST_INVALID_STATE - The stats failed to retrieve due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_DeviceGetSampleCacheStats(EST_DEVICE_HANDLE device_handle, est_sample_cache_stats *stats);
+
 // Shutdown the audio system
 // Returns:
 // EST_OK - The audio system was shutdown successfully
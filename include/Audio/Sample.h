@@ -18,20 +18,78 @@ extern "C" {
 // EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
 EST_API enum EST_RESULT EST_SampleLoad(EST_DEVICE_HANDLE device_handle, const char *path, EST_AUDIO_HANDLE *handle);
 
-// Get the sample rate of the audio system
+// Load an audio sample, opening it with the decoder for format only
+// Note: EST_FORMAT_AUTO detects the format from the file header and extension (EST_SampleLoad does the same).
+//       A wrong hint still loads, it falls back to probing every decoder.
+// Params:
+// path - The path to the audio file
+// format - The container format of the file [see EST_AUDIO_FORMAT]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadWithFormat(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from an audio file held in memory, detecting its format
+// Note: data is not copied, see EST_SampleLoadMemoryBorrowed for its lifetime
+// Params:
+// data - The data of the audio file
+// size - The size of the data in bytes
+// handle - Receives the handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE device_handle, const void *data, int size, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory, opening it with the decoder for format only
+// Note: data is not copied, see EST_SampleLoadMemoryBorrowed for its lifetime
 // Params:
 // data - The data of the audio file
 // size - The size of the audio file
+// format - The container format of the data [see EST_AUDIO_FORMAT]
 // handle - The handle to the audio sample
 // Returns:
 // EST_OK - The sample was loaded successfully
 // EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
 // EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
 // EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
-EST_API enum EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE device_handle, const void *data, int size, EST_AUDIO_HANDLE *handle);
+EST_API enum EST_RESULT EST_SampleLoadMemoryWithFormat(EST_DEVICE_HANDLE device_handle, const void *data, int size, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory without copying it
+// Note: The sample decodes straight from data, it must stay valid until EST_SampleFree returns
+// Params:
+// data - The data of the audio file
+// size - The size of the audio file
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadMemoryBorrowed(EST_DEVICE_HANDLE device_handle, const void *data, int size, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory, taking ownership of it without copying
+// Note: release is called exactly once when the sample no longer needs data, also when loading fails.
+//       It may run on the audio thread and must not block.
+// Params:
+// data - The data of the audio file
+// size - The size of the audio file
+// release - The callback that frees data, can be nullptr
+// userData - The user data passed to release
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadMemoryOwned(EST_DEVICE_HANDLE device_handle, void *data, int size, est_release_callback release, void *userData, EST_AUDIO_HANDLE *handle);
 
 // Load a raw PCM audio sample
-// Note: Must be in format 32-bit float, 2 channel interleaved
+// Note: Must be in format 32-bit float, 2 channel interleaved. data is copied
 // Params:
 // data - The data of the audio file
 // pcmSize - The size of raw audio in pcm size
@@ -45,6 +103,180 @@ EST_API enum EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE device_handle, co
 // EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
 EST_API enum EST_RESULT EST_SampleLoadRawPCM(EST_DEVICE_HANDLE device_handle, const void *data, int pcmSize, int channels, int sampleRate, EST_AUDIO_HANDLE *handle);
 
+// Load a raw PCM audio sample without copying it
+// Note: Must be in format 32-bit float, interleaved. data must stay valid until EST_SampleFree returns
+// Params:
+// data - The raw PCM frames
+// pcmSize - The size of raw audio in pcm size
+// channels - The number of channels of the audio file
+// sampleRate - The sample rate of the audio file
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadRawPCMBorrowed(EST_DEVICE_HANDLE device_handle, const float *data, int pcmSize, int channels, int sampleRate, EST_AUDIO_HANDLE *handle);
+
+// Load a raw PCM audio sample, taking ownership of it without copying
+// Note: Must be in format 32-bit float, interleaved. release is called exactly once when the sample
+//       no longer needs data, also when loading fails. It may run on the audio thread and must not block.
+// Params:
+// data - The raw PCM frames
+// pcmSize - The size of raw audio in pcm size
+// channels - The number of channels of the audio file
+// sampleRate - The sample rate of the audio file
+// release - The callback that frees data, can be nullptr
+// userData - The user data passed to release
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadRawPCMOwned(EST_DEVICE_HANDLE device_handle, float *data, int pcmSize, int channels, int sampleRate, est_release_callback release, void *userData, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample streamed through caller callbacks, e.g. straight out of an archive
+// Note: The callbacks are called from the thread that loads, the audio thread while playing, or the
+//       read-ahead thread with EST_IO_READAHEAD, but never from two threads at once.
+//       io->close is called once the sample is freed, or right away when loading fails.
+// Params:
+// io - The callbacks reading the source [see est_io_callbacks]
+// format - The container format of the source [see EST_AUDIO_FORMAT]
+// flags - The stream flags [see EST_IO_FLAGS]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadCallbacks(EST_DEVICE_HANDLE device_handle, const est_io_callbacks *io, enum EST_AUDIO_FORMAT format, enum EST_IO_FLAGS flags, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample streamed from a file, for long voices such as music
+// Note: With EST_IO_READAHEAD a background thread reads the file in large sequential blocks, so the
+//       audio thread only copies from memory. When the buffer runs dry (after a seek, or a source slower
+//       than playback) the sample plays silence until it refills instead of waiting on the file.
+//       Sequential access is hinted to the kernel on Linux.
+// Params:
+// path - The path to the audio file
+// format - The container format of the file [see EST_AUDIO_FORMAT]
+// flags - The stream flags [see EST_IO_FLAGS]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadStream(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_AUDIO_FORMAT format, enum EST_IO_FLAGS flags, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample fully decoded into memory at the device sample rate
+// Note: Long files are split into ranges decoded in parallel on every core.
+//       The sample never touches the decoder again, seeks and loops are free.
+//       With a cache directory set the frames are stored there and mapped on later loads [see EST_DeviceSetCacheDirectory].
+// Params:
+// path - The path to the audio file
+// format - The container format of the file [see EST_AUDIO_FORMAT]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadDecoded(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample fully decoded into memory, kept in a compact storage format
+// Note: Frames are converted back to float while mixing. EST_STORAGE_S16 and EST_STORAGE_F16 halve the memory,
+//       EST_STORAGE_ADPCM takes an eighth of it at a small loss in quality [see EST_SAMPLE_STORAGE].
+// Params:
+// path - The path to the audio file
+// format - The container format of the file [see EST_AUDIO_FORMAT]
+// storage - The storage format of the frames [see EST_SAMPLE_STORAGE]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadDecodedWithStorage(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_AUDIO_FORMAT format, enum EST_SAMPLE_STORAGE storage, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory fully decoded at the device sample rate
+// Note: data is only read during the call and can be freed afterwards
+// Params:
+// data - The data of the audio file
+// size - The size of the audio file
+// format - The container format of the data [see EST_AUDIO_FORMAT]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadMemoryDecoded(EST_DEVICE_HANDLE device_handle, const void *data, int size, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory fully decoded, kept in a compact storage format [see EST_SampleLoadDecodedWithStorage]
+EST_API enum EST_RESULT EST_SampleLoadMemoryDecodedWithStorage(EST_DEVICE_HANDLE device_handle, const void *data, int size, enum EST_AUDIO_FORMAT format, enum EST_SAMPLE_STORAGE storage, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample fully decoded with extra passes over the frames
+// Note: Silence is trimmed before the frames are packed and pooled, the disk cache keeps the untrimmed frames.
+//       A sound that is silent throughout is kept whole. Analysis runs once per pooled sound on the device worker
+//       and is measured over the frames that were kept [see EST_SampleGetAnalysis].
+// Params:
+// path - The path to the audio file
+// format - The container format of the file [see EST_AUDIO_FORMAT]
+// options - Storage and passes [see est_decode_options]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadDecodedEx(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_AUDIO_FORMAT format, const est_decode_options *options, EST_AUDIO_HANDLE *handle);
+
+// Load an audio sample from memory fully decoded with extra passes over the frames [see EST_SampleLoadDecodedEx]
+EST_API enum EST_RESULT EST_SampleLoadMemoryDecodedEx(EST_DEVICE_HANDLE device_handle, const void *data, int size, enum EST_AUDIO_FORMAT format, const est_decode_options *options, EST_AUDIO_HANDLE *handle);
+
+// Get the load analysis of a decoded sample
+// Note: Measurements arrive asynchronously, isReady stays EST_FALSE until the worker is done
+//       and for good when no load of the sound asked for EST_DECODE_ANALYZE.
+// Params:
+// handle - The handle to the audio sample
+// analysis - Receives the analysis [see est_sample_analysis]
+// Returns:
+// EST_OK - The analysis was retrieved successfully
+// EST_INVALID_ARGUMENT - The handle or analysis is invalid
+// EST_INVALID_OPERATION - The sample was not loaded decoded (EST_SampleLoadDecoded and its variants)
+// EST_INVALID_STATE - Not initialized
+EST_API enum EST_RESULT EST_SampleGetAnalysis(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle, est_sample_analysis *analysis);
+
+// Load an audio sample through a read-only file mapping
+// Note: 32-bit float WAV at the device sample rate plays straight from the mapped pages,
+//       other files are decoded from the mapping. Every handle of the same file shares one mapping.
+// Params:
+// path - The path to the audio file
+// flags - The mapping flags [see EST_MAP_FLAGS]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadMapped(EST_DEVICE_HANDLE device_handle, const char *path, enum EST_MAP_FLAGS flags, EST_AUDIO_HANDLE *handle);
+
+// Load a raw PCM file through a read-only file mapping, without copying
+// Note: Must be in format 32-bit float, interleaved, without header
+// Params:
+// path - The path to the raw PCM file
+// channels - The number of channels of the audio file
+// sampleRate - The sample rate of the audio file
+// flags - The mapping flags [see EST_MAP_FLAGS]
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The sample was loaded successfully
+// EST_OUT_OF_MEMORY - The sample failed to load due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to load due to invalid arguments
+// EST_INVALID_STATE - The sample failed to load due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleLoadRawPCMMapped(EST_DEVICE_HANDLE device_handle, const char *path, int channels, int sampleRate, enum EST_MAP_FLAGS flags, EST_AUDIO_HANDLE *handle);
+
 // Unload the audio sample
 // Params:
 // handle - The handle to the audio sample
@@ -131,6 +363,44 @@ EST_API enum EST_RESULT EST_SampleSlideAttribute(EST_DEVICE_HANDLE device_handle
 // EST_INVALID_STATE - The sample failed to play due to invalid state (Not initialized)
 EST_API enum EST_RESULT EST_SampleSlideAttributeAsync(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle, enum EST_ATTRIBUTE_FLAGS attribute, float value, float time);
 
+// Set the loop region used while EST_ATTRIB_LOOPING is enabled
+// Note: The start of the region is decoded ahead of time, so the wrap is gapless and never waits on the decoder
+// Params:
+// handle - The handle to the audio sample
+// loopStart - The frame the loop wraps back to
+// loopEnd - The frame the loop wraps at (exclusive), 0 meaning the end of the sample
+// crossfade - The crossfade length in frames at the wrap, 0 meaning no crossfade
+//             (limited to the frames available before loopStart)
+// Returns:
+// EST_OK - The loop region was set successfully
+// EST_OUT_OF_MEMORY - The loop region failed to set due to lack of memory
+// EST_INVALID_ARGUMENT - The loop region failed to set due to invalid arguments
+// EST_INVALID_STATE - The loop region failed to set due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleSetLoopRegion(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle, int loopStart, int loopEnd, int crossfade);
+
+// Queue another sample to start on the exact frame this one ends (gapless)
+// Note: The queued sample is rewound and its first blocks are decoded ahead of time,
+//       later entries are handed over to the queued sample when it starts
+// Params:
+// handle - The handle to the audio sample
+// next - The handle to the audio sample to play next
+// crossfade - The crossfade length in frames into the next sample, 0 meaning a gapless cut
+// Returns:
+// EST_OK - The sample was queued successfully
+// EST_OUT_OF_MEMORY - The sample failed to queue due to lack of memory
+// EST_INVALID_ARGUMENT - The sample failed to queue due to invalid arguments
+// EST_INVALID_STATE - The sample failed to queue due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleQueue(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle, EST_AUDIO_HANDLE next, int crossfade);
+
+// Remove every sample queued after the audio sample
+// Params:
+// handle - The handle to the audio sample
+// Returns:
+// EST_OK - The queue was cleared successfully
+// EST_INVALID_ARGUMENT - The queue failed to clear due to invalid arguments
+// EST_INVALID_STATE - The queue failed to clear due to invalid state (Not initialized)
+EST_API enum EST_RESULT EST_SampleClearQueue(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle);
+
 EST_API enum EST_RESULT EST_SampleSetCallback(EST_DEVICE_HANDLE device_handle, EST_AUDIO_HANDLE handle, est_audio_callback callback, void *userdata);
 EST_API enum EST_RESULT EST_SampleSetGlobalCallback(EST_DEVICE_HANDLE device_handle, est_audio_callback callback, void *userdata);
 
@@ -5,6 +5,7 @@
 
 #include "Audio/Device.h"
 #include "Audio/Sample.h"
+#include "Audio/Bank.h"
 
 #if __cplusplus
 extern "C" {
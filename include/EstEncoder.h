@@ -13,6 +13,13 @@ EST_API enum EST_RESULT EST_EncoderLoad(const char *path, est_encoder_callback c
 // Load audio file from memory as encoder channel
 EST_API enum EST_RESULT EST_EncoderLoadMemory(const void *data, int size, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, EST_ENCODER_HANDLE *handle);
 
+// Load file as encoder channel, opening it with the decoder for format only
+// Note: EST_FORMAT_AUTO detects the format from the file header, a wrong hint falls back to probing
+EST_API enum EST_RESULT EST_EncoderLoadWithFormat(const char *path, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, enum EST_AUDIO_FORMAT format, EST_ENCODER_HANDLE *handle);
+
+// Load audio file from memory as encoder channel, opening it with the decoder for format only
+EST_API enum EST_RESULT EST_EncoderLoadMemoryWithFormat(const void *data, int size, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, enum EST_AUDIO_FORMAT format, EST_ENCODER_HANDLE *handle);
+
 // Free the encoder channel
 EST_API enum EST_RESULT EST_EncoderFree(EST_ENCODER_HANDLE handle);
 
@@ -22,6 +29,64 @@ EST_API enum EST_RESULT EST_EncoderGetInfo(EST_ENCODER_HANDLE handle, est_encode
 // Note: You don't need use this channel if you using EST_GetSampleChannel
 EST_API enum EST_RESULT EST_EncoderRender(EST_ENCODER_HANDLE handle);
 
+// Render the encoder channel with the time stretching split across threads
+// Note: The source is cut into segments stretched on their own thread, each one starts early enough to
+//       settle the stretcher and is crossfaded into the one before. Without a tempo or pitch change,
+//       or when the source is too short to split, this renders exactly like EST_EncoderRender.
+// Params:
+// threadCount - The number of threads to use, 0 for every core
+// Returns:
+// EST_OK - The encoder channel was rendered successfully
+// EST_OUT_OF_MEMORY - The render failed due to lack of memory
+// EST_INVALID_ARGUMENT - The handle or thread count is invalid
+EST_API enum EST_RESULT EST_EncoderRenderParallel(EST_ENCODER_HANDLE handle, int threadCount);
+
+// Render only part of the encoder channel, for previews
+// Note: The stretcher is primed at start like a full render, so the range sounds the same as that part of
+//       EST_EncoderRender output while only the range is read and stretched. The rendered frames replace
+//       the encoder data, ending early when the source does.
+// Params:
+// start - The first frame of the range
+// end - The frame after the last one of the range
+// unit - Whether start and end count source frames or output frames
+// Returns:
+// EST_OK - The range was rendered successfully
+// EST_OUT_OF_MEMORY - The render failed due to lack of memory
+// EST_INVALID_ARGUMENT - The handle is invalid, the range is empty or starts past the end of the source
+EST_API enum EST_RESULT EST_EncoderRenderRange(EST_ENCODER_HANDLE handle, long long start, long long end, enum EST_RANGE_UNIT unit);
+
+// Render several tempo/pitch/volume/pan variants of the encoder channel in one pass
+// Note: The source is decoded once and shared, each variant renders on its own core with its own chain.
+//       Every output is a new encoder channel holding the rendered data, use it like one after
+//       EST_EncoderRender (EST_EncoderGetData, EST_EncoderExportFile, ...) and free it when done.
+//       Outputs start with every attribute of handle (sample rate and export quality included), then apply their own.
+//       The callback and user data of handle are carried over to every output, the callback runs on several threads at once.
+// Params:
+// variants - The variants to render [see est_encoder_variant]
+// variantCount - The number of variants
+// outputs - Receives variantCount encoder handles, all null on failure
+// Returns:
+// EST_OK - Every variant was rendered successfully
+// EST_OUT_OF_MEMORY - The render failed due to lack of memory
+// EST_INVALID_ARGUMENT - The handle or arguments are invalid
+EST_API enum EST_RESULT EST_EncoderRenderVariants(EST_ENCODER_HANDLE handle, const est_encoder_variant *variants, int variantCount, EST_ENCODER_HANDLE *outputs);
+
+// Render the next frames of the encoder channel into data
+// Note: The first call starts from the beginning of the source, later calls continue where the last one stopped.
+//       Frames are rendered in small chunks straight from the decoder, so memory stays constant however long the source is.
+//       The callback sees every chunk as it is rendered. framesRead below maxFrames means the end was reached.
+// Params:
+// data - Receives up to maxFrames interleaved f32 frames at the encoder channel count [see EST_EncoderGetInfo]
+// maxFrames - The number of frames data can hold
+// framesRead - Receives the number of frames written, 0 at the end
+// Returns:
+// EST_OK - The frames were rendered successfully
+// EST_INVALID_ARGUMENT - The handle or arguments are invalid
+EST_API enum EST_RESULT EST_EncoderReadFrames(EST_ENCODER_HANDLE handle, float *data, int maxFrames, int *framesRead);
+
+// Restart EST_EncoderReadFrames from the beginning of the source
+EST_API enum EST_RESULT EST_EncoderResetStream(EST_ENCODER_HANDLE handle);
+
 // Set the encoder channel attribute
 EST_API enum EST_RESULT EST_EncoderSetAttribute(EST_ENCODER_HANDLE handle, enum EST_ATTRIBUTE_FLAGS attribute, float value);
 
@@ -35,6 +100,24 @@ EST_API enum EST_RESULT EST_EncoderGetData(EST_ENCODER_HANDLE handle, void *data
 // Flush the encoder channel
 EST_API enum EST_RESULT EST_EncoderFlushData(EST_ENCODER_HANDLE handle);
 
+// Cache rendered output on disk, keyed by the source content and every attribute that changes the output
+// Note: EST_EncoderRender, EST_EncoderRenderParallel and EST_EncoderGetSample map the frames on a hit instead of rendering.
+//       Encoders with a callback are never cached, the callback has to see every chunk. Once the entries pass
+//       maxBytes the least recently used ones are deleted. Applies to every encoder.
+// Params:
+// directory - Where entries are kept, null or empty disables the cache
+// maxBytes - Size limit of the directory, 0 for no limit
+// Returns:
+// EST_OK - The cache was set successfully
+// EST_OUT_OF_MEMORY - The directory could not be stored
+// EST_INVALID_ARGUMENT - maxBytes is negative
+EST_API enum EST_RESULT EST_EncoderSetRenderCache(const char *directory, long long maxBytes);
+
+// Drop the decoded source and stretched frames kept between renders
+// Note: Renders keep both so a later render with the same tempo and pitch only redoes volume, pan
+//       and the callback. Call this once no more renders are coming to give the memory back early.
+EST_API enum EST_RESULT EST_EncoderReleaseCache(EST_ENCODER_HANDLE handle);
+
 // Get available decoded PCM data length
 // Note: Must use EST_EncoderRender first to get the decoded data
 EST_API enum EST_RESULT EST_EncoderGetAvailableDataSize(EST_ENCODER_HANDLE handle, int *size);
@@ -42,18 +125,75 @@ EST_API enum EST_RESULT EST_EncoderGetAvailableDataSize(EST_ENCODER_HANDLE handl
 // Convert encoder channel to Sample channel
 // Note: No need to use EST_EncoderRender
 // Note2: You need free the out sample after you done used it.
+// Note3: The encoder renders at the device sample rate from then on, an output at another rate is rendered again.
+//        The rendered frames are shared with the sample, not copied, and stay readable from the encoder.
 EST_API enum EST_RESULT EST_EncoderGetSample(EST_ENCODER_HANDLE handle, EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE *outSample);
 
 // Export the encoder channel to file
 // Note: Need to call EST_EncoderRender first
 EST_API enum EST_RESULT EST_EncoderExportFile(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, char *filePath);
 
-// INTERNAL, set error message (NOT THREAD SAFE)
+// Export the encoder channel to file with export options
+// Note: The file is written block by block, memory stays the same however long the render is.
+//       With EST_EXPORT_STREAM the render happens during the export instead of EST_EncoderRender,
+//       restarting any EST_EncoderReadFrames stream. Ogg Vorbis and Opus streamed this way compress on
+//       a second thread while the render goes on, so the export costs about as long as the render alone.
+// Params:
+// type - The file format
+// flags - EST_EXPORT_FLAGS, combined
+// filePath - The file to write
+// Returns:
+// EST_OK - The file was written successfully
+// EST_ERROR_ENCODER_EMPTY - Nothing is rendered and EST_EXPORT_STREAM is not set
+// EST_ERROR_ENCODER_UNSUPPORTED - The export type is unknown
+// EST_ERROR_ENCODER_INVALID_WRITE - The file could not be written
+// EST_INVALID_ARGUMENT - The handle or path is invalid, the file could not be created or the format
+//                        doesn't take the channel count or sample rate
+EST_API enum EST_RESULT EST_EncoderExportFileEx(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const char *filePath);
+
+// Export the encoder channel to a memory buffer, same as EST_EncoderExportFileEx without a file
+// Note: The buffer grows as the export goes, free it with EST_EncoderFreeExport.
+// Params:
+// data - Receives the exported bytes, untouched on failure
+// size - Receives the number of bytes
+// Returns:
+// EST_OK - The buffer was written successfully
+// EST_ERROR_ENCODER_INVALID_WRITE - The buffer could not grow any further
+// Others as EST_EncoderExportFileEx
+EST_API enum EST_RESULT EST_EncoderExportMemory(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, void **data, size_t *size);
+
+// Export the encoder channel through caller callbacks, same as EST_EncoderExportFileEx without a file
+// Note: WAV needs the seek callback, Ogg Vorbis and Opus only ever append. The close callback runs once
+//       the export is done, including when it fails.
+// Params:
+// output - The callbacks receiving the bytes [see est_export_callbacks]
+// Returns:
+// EST_ERROR_ENCODER_INVALID_WRITE - A callback wrote fewer bytes than given or failed to seek
+// Others as EST_EncoderExportFileEx
+EST_API enum EST_RESULT EST_EncoderExportCallbacks(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const est_export_callbacks *output);
+
+// Free a buffer from EST_EncoderExportMemory
+EST_API void EST_EncoderFreeExport(void *data);
+
+// Run many conversions (load, attributes, render, export) on a pool of threads
+// Note: Blocks until every job is done. Each job reports its own result and error, a failed job
+//       doesn't stop the others. Every job renders on a single thread, the pool is the parallelism.
+// Params:
+// jobs - The jobs to run, their result fields are filled in [see est_encoder_job]
+// jobCount - The number of jobs
+// threadCount - The number of jobs run at once, 0 for every core
+// summary - Receives the throughput of the batch, can be null [see est_batch_summary]
+// Returns:
+// EST_OK - Every job ran, check each job result
+// EST_INVALID_ARGUMENT - The jobs or counts are invalid
+EST_API enum EST_RESULT EST_EncoderRunBatch(est_encoder_job *jobs, int jobCount, int threadCount, est_batch_summary *summary);
+
+// INTERNAL, set error message of the calling thread
 // Params:
 // error - The error message
 EST_API enum EST_RESULT EST_EncoderSetError(const char *error);
 
-// Get error message whatever the API function return != ES_OK (NOT THREAD SAFE)
+// Get error message whatever the API function return != ES_OK, each thread has its own
 // Returns:
 // The error message
 // or
@@ -1,6 +1,8 @@
 #ifndef __EST_TYPES_H
 #define __EST_TYPES_H
 
+#include <stddef.h>
+
 // clang-format off
 #if defined(EST_EXPORT)
     #if defined(_WIN32)
@@ -60,6 +62,63 @@ enum EST_DECODER_FLAGS {
     EST_DECODER_FORMAT_F32, // (NOT IMPLEMENTED)
 };
 
+// File mapping flags, can be combined
+enum EST_MAP_FLAGS {
+    EST_MAP_DEFAULT = 0,
+    EST_MAP_POPULATE = 1,  // Fault in every page at load (MAP_POPULATE, Linux only)
+    EST_MAP_WILLNEED = 2,  // Ask the kernel to read ahead the whole file in the background
+    EST_MAP_SEQUENTIAL = 4 // Hint the file is read front to back
+};
+
+// Container format hint for loading, lets the right decoder open the file on the first try
+enum EST_AUDIO_FORMAT {
+    EST_FORMAT_AUTO = 0, // Detect from the leading bytes and the file extension
+    EST_FORMAT_WAV,
+    EST_FORMAT_FLAC,
+    EST_FORMAT_MP3,
+    EST_FORMAT_VORBIS, // Ogg Vorbis
+    EST_FORMAT_OPUS    // Ogg Opus
+};
+
+// Stream loading flags, can be combined
+enum EST_IO_FLAGS {
+    EST_IO_DEFAULT = 0,  // The decoder reads the source directly
+    EST_IO_READAHEAD = 1 // A background thread reads the source ahead in large blocks, decoder reads are served from memory
+};
+
+enum EST_SEEK_ORIGIN {
+    EST_SEEK_SET = 0, // From the start of the source
+    EST_SEEK_CUR = 1, // From the current position
+    EST_SEEK_END = 2  // From the end of the source
+};
+
+// How decoded samples are kept in memory, converted back to float while mixing
+enum EST_SAMPLE_STORAGE {
+    EST_STORAGE_F32 = 0,  // 32 bit float, no conversion
+    EST_STORAGE_S16 = 1,  // 16 bit PCM, half the memory
+    EST_STORAGE_F16 = 2,  // 16 bit half float, half the memory with float dynamics
+    EST_STORAGE_ADPCM = 3 // 4 bit IMA ADPCM, an eighth of the memory, lossy
+};
+
+// Decoded load passes, can be combined [see est_decode_options]
+enum EST_DECODE_FLAGS {
+    EST_DECODE_DEFAULT = 0,      // Keep every frame, no analysis
+    EST_DECODE_TRIM_SILENCE = 1, // Drop the frames at the start and the end quieter than silenceThreshold
+    EST_DECODE_ANALYZE = 2       // Measure peak, RMS and loudness on the device worker [see EST_SampleGetAnalysis]
+};
+
+// Time base of an encoder render range [see EST_EncoderRenderRange]
+enum EST_RANGE_UNIT {
+    EST_RANGE_SOURCE = 0, // Frames of the source, before the tempo change
+    EST_RANGE_OUTPUT = 1  // Frames of the rendered output, after the tempo change
+};
+
+// Sound bank payload flags, can be combined
+enum EST_BANK_FLAGS {
+    EST_BANK_DEFAULT = 0, // Store each file as it is, decoded from the mapped bank when loaded
+    EST_BANK_DECODED = 1  // Store f32 PCM, samples play straight from the mapped bank without a decoder
+};
+
 enum EST_ATTRIBUTE_FLAGS {
     EST_ATTRIB_UNKNOWN,
 
@@ -72,6 +131,7 @@ enum EST_ATTRIBUTE_FLAGS {
     EST_ATTRIB_ENCODER_TEMPO = 5,      // Encoder tempo control which change audio rate without pitch change (different from sampleRate)
     EST_ATTRIB_ENCODER_PITCH = 6,      // Encoder pitch control without change the audio rate
     EST_ATTRIB_ENCODER_SAMPLERATE = 7, // Encoder both tempo and pitch control
+    EST_ATTRIB_ENCODER_QUALITY = 8,    // Encoder compressed export quality, 0 (smallest) to 1 (best), 0.5 by default
 };
 
 enum EST_STATUS {
@@ -82,23 +142,42 @@ enum EST_STATUS {
     EST_STATUS_AT_END
 };
 
-// Export file format, currently only support WAV
-// More format coming soon
+// Export file format
 enum EST_FILE_EXPORT {
     EST_EXPORT_UNKNOWN,
-    EST_EXPORT_WAV // Export sample as wav 16bit format
+    EST_EXPORT_WAV,        // Export sample as wav 16bit format
+    EST_EXPORT_WAV_S24,    // Export sample as wav 24bit format
+    EST_EXPORT_WAV_S32,    // Export sample as wav 32bit format
+    EST_EXPORT_WAV_F32,    // Export sample as wav 32bit float format, exactly the rendered data
+    EST_EXPORT_OGG_VORBIS, // Export sample as ogg vorbis, VBR from EST_ATTRIB_ENCODER_QUALITY, channels reordered from WAV to Vorbis order
+    EST_EXPORT_OGG_OPUS    // Export sample as ogg opus (mono or stereo), bitrate from EST_ATTRIB_ENCODER_QUALITY
+};
+
+// Export options, can be combined [see EST_EncoderExportFileEx]
+enum EST_EXPORT_FLAGS {
+    EST_EXPORT_DEFAULT = 0, // Export the rendered data, integer formats truncate
+    EST_EXPORT_DITHER = 1,  // Add TPDF dither to 16 and 24 bit formats
+    EST_EXPORT_STREAM = 2   // Render straight into the file, nothing is kept in the encoder [see EST_EncoderReadFrames]
 };
 
 typedef unsigned int EST_AUDIO_HANDLE;   // EstAudio handle, used for playback channel, thread safety: safe
 typedef void        *EST_DEVICE_HANDLE;  // EstDeviceHandle, used for audio system, thread safety: safe
 typedef void        *EST_ENCODER_HANDLE; // EstEncoder handle, used for encoder channel, thread safety: safe
 typedef void        *EST_CHANNEL_HANDLE; // EstChannel handle, used for channel handle for EST_AUDIO_HANDLE, thread safety: safe
+typedef void        *EST_BANK_HANDLE;    // EstBank handle, used for a mapped sound bank, thread safety: safe
 typedef unsigned int EUINT32;
 #define INVALID_HANDLE -1
 #define INVALID_ECHANDLE (void *)0
 
 typedef void (*est_audio_callback)(EST_AUDIO_HANDLE pHandle, void *pUserData, void *pData, int frameCount);
 typedef void (*est_encoder_callback)(EST_ENCODER_HANDLE pHandle, void *pUserData, void *pData, int frameCount);
+typedef void (*est_release_callback)(void *pData, void *pUserData); // Gives a buffer handed to EstAudio back to its owner
+
+typedef size_t (*est_read_callback)(void *pUserData, void *pBuffer, size_t size);                 // Returns the bytes read, 0 at the end
+typedef int (*est_seek_callback)(void *pUserData, long long offset, enum EST_SEEK_ORIGIN origin); // Returns 0 on success
+typedef long long (*est_tell_callback)(void *pUserData);                                          // Returns the position, negative on failure
+typedef void (*est_close_callback)(void *pUserData);                                              // Called once the source is no longer read
+typedef size_t (*est_write_callback)(void *pUserData, const void *pData, size_t size);            // Returns the bytes written, fewer on failure
 
 typedef struct
 {
@@ -115,4 +194,116 @@ typedef struct
     int pcmSize;
 } est_encoder_info;
 
+// Values of est_encoder_variant and est_encoder_job that apply, can be combined
+enum EST_VARIANT_FIELDS {
+    EST_VARIANT_INHERIT = 0, // Everything as on the source encoder
+    EST_VARIANT_TEMPO = 1,
+    EST_VARIANT_PITCH = 2,
+    EST_VARIANT_VOLUME = 4,
+    EST_VARIANT_PAN = 8,
+    EST_VARIANT_SAMPLERATE = 16 // est_encoder_job only, a variant always keeps the source sample rate
+};
+
+// One conversion of a batch [see EST_EncoderRunBatch], every attribute not named in fields keeps the source value
+typedef struct
+{
+    const char            *inputPath;
+    enum EST_AUDIO_FORMAT  inputFormat; // EST_FORMAT_AUTO to detect
+    enum EST_DECODER_FLAGS flags;
+    int                    fields;     // EST_VARIANT_FIELDS
+    float                  tempo;      // EST_ATTRIB_ENCODER_TEMPO
+    float                  pitch;      // EST_ATTRIB_ENCODER_PITCH
+    float                  sampleRate; // EST_ATTRIB_ENCODER_SAMPLERATE
+    float                  volume;     // EST_ATTRIB_VOLUME
+    float                  pan;        // EST_ATTRIB_PAN, 0 is centered
+    enum EST_FILE_EXPORT   exportType;
+    const char            *outputPath;
+
+    // Filled in by the batch
+    enum EST_RESULT result;
+    char            error[256];   // Empty on success
+    double          seconds;      // Wall time of the job
+    double          audioSeconds; // Length of the rendered audio
+} est_encoder_job;
+
+// One output of EST_EncoderRenderVariants, every attribute not named in fields is taken from the source encoder
+typedef struct
+{
+    int   fields; // EST_VARIANT_FIELDS
+    float tempo;  // EST_ATTRIB_ENCODER_TEMPO
+    float pitch;  // EST_ATTRIB_ENCODER_PITCH
+    float volume; // EST_ATTRIB_VOLUME
+    float pan;    // EST_ATTRIB_PAN
+} est_encoder_variant;
+
+// Throughput of a batch [see EST_EncoderRunBatch]
+typedef struct
+{
+    int    jobs;
+    int    failed;
+    double seconds;        // Wall time of the whole batch
+    double audioSeconds;   // Rendered audio of the jobs that succeeded
+    double filesPerSecond; // Jobs that succeeded per second of wall time
+    double realtime;       // Audio seconds rendered per second of wall time
+} est_batch_summary;
+
+// Sample cache usage [see EST_DeviceGetSampleCacheStats]
+typedef struct
+{
+    long long budget;      // Bytes unused sounds may keep cached
+    long long bytes;       // Bytes of every cached sound, in use or not
+    long long unusedBytes; // Bytes of cached sounds no handle uses
+    int       entries;     // Cached sounds
+    long long hits;        // Loads served from the cache
+    long long misses;      // Loads that had to decode or copy
+    long long evictions;   // Unused sounds dropped to stay within the budget
+} est_sample_cache_stats;
+
+// Caller file access for streaming loads, the callbacks are only ever called from one thread at a time
+typedef struct
+{
+    est_read_callback  read;
+    est_seek_callback  seek;
+    est_tell_callback  tell;
+    est_close_callback close; // Optional
+    void              *userData;
+} est_io_callbacks;
+
+// Caller output for exports, the callbacks are only ever called from one thread at a time, not always the caller's
+typedef struct
+{
+    est_write_callback write;
+    est_seek_callback  seek;  // Optional for Ogg exports, WAV needs it to patch its header once the data is written
+    est_close_callback close; // Optional, called once the export is done, even when it failed
+    void              *userData;
+} est_export_callbacks;
+
+// One sound of a bank being built
+typedef struct
+{
+    const char *path;      // The audio file to store
+    const char *name;      // The name to look the sound up by, the path when null
+    int         loopStart; // Loop region start in frames of the file
+    int         loopEnd;   // Loop region end in frames of the file, 0 for no loop region
+} est_bank_entry;
+
+// Decoded load options [see EST_SampleLoadDecodedEx]
+typedef struct
+{
+    enum EST_SAMPLE_STORAGE storage;          // How the frames are kept in memory
+    enum EST_DECODE_FLAGS   flags;            // Passes run on the decoded frames
+    float                   silenceThreshold; // dBFS, a frame is silent when every channel stays below it
+} est_decode_options;
+
+// Load analysis of a decoded sample [see EST_SampleGetAnalysis]
+typedef struct
+{
+    enum EST_BOOL isReady;      // The measurements below are set, trim counts always are
+    float         peak;         // Largest absolute sample, linear full scale
+    float         rms;          // Over every channel, linear full scale
+    float         loudness;     // Integrated loudness in LUFS (ITU-R BS.1770), -inf for silence
+    long long     trimmedStart; // Frames of leading silence dropped at load
+    long long     trimmedEnd;   // Frames of trailing silence dropped at load
+} est_sample_analysis;
+
 #endif
\ No newline at end of file
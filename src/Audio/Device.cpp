@@ -1,4 +1,5 @@
 #include "Internal.h"
+#include "Sample/SampleInternal.h"
 
 namespace {
     constexpr int           kMaxChannels = 2;
@@ -6,7 +7,31 @@ namespace {
     std::string             g_error;
 } // namespace
 
-static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device, std::shared_ptr<EST_AudioSample> sample, float *pOutput, ma_uint32 frameCount)
+static void data_apply_fade(EST_Fade &fade, float *pFrames, ma_uint64 frameCount, int channels)
+{
+    if (fade.length == 0) {
+        return;
+    }
+
+    for (ma_uint64 iFrame = 0; iFrame < frameCount; ++iFrame) {
+        float gain = fade.to;
+        if (fade.position < fade.length) {
+            gain = fade.from + (fade.to - fade.from) * (static_cast<float>(fade.position) / static_cast<float>(fade.length));
+            fade.position++;
+        }
+
+        for (int c = 0; c < channels; ++c) {
+            pFrames[iFrame * channels + c] *= gain;
+        }
+    }
+
+    // A finished fade-in no longer needs to touch the frames
+    if (fade.position >= fade.length && fade.to == 1.0f) {
+        fade = {};
+    }
+}
+
+static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device, std::shared_ptr<EST_AudioSample> sample, float *pOutput, ma_uint32 frameCount, bool *isAtEnd)
 {
     int       channels = device->channels;
     ma_result result = MA_SUCCESS;
@@ -40,18 +65,14 @@ static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device,
                 &framesToReadThisIteration);
         }
 
-        if (sample->rawAudio) {
-            framesReadThisIteration = ma_audio_buffer_read_pcm_frames(&sample->rawAudio->decoder, &temp[0], framesToReadThisIteration, MA_FALSE);
-            if (framesReadThisIteration == 0) {
-                break;
-            }
-        } else {
-            result = ma_decoder_read_pcm_frames(&sample->decoder, &temp[0], framesToReadThisIteration, &framesReadThisIteration);
-            if (result != MA_SUCCESS || framesReadThisIteration == 0) {
-                break;
-            }
+        // Loop wrapping happens inside, so a looping sample always fills the block
+        ma_uint64 framesDecodedThisIteration = SampleReadFrames(device, sample, &temp[0], framesToReadThisIteration, isAtEnd);
+        if (framesDecodedThisIteration == 0) {
+            break;
         }
 
+        framesReadThisIteration = framesDecodedThisIteration;
+
         if (sample->channels != device->channels) {
             ma_channel_converter_process_pcm_frames(&sample->converter, &temp2[0], &temp[0], framesReadThisIteration);
 
@@ -89,6 +110,8 @@ static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device,
             break;
         }
 
+        data_apply_fade(sample->fade, &temp[0], framesReadThisIteration, channels);
+
         /* Mix the frames together. */
         for (iSample = 0; iSample < framesReadThisIteration * channels; ++iSample) {
             pOutput[totalFramesRead * channels + iSample] += temp[iSample]; // std::clamp(temp[iSample], -1.0f, 1.0f);
@@ -96,7 +119,7 @@ static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device,
 
         totalFramesRead += (ma_uint32)framesReadThisIteration;
 
-        if (framesReadThisIteration < (ma_uint32)framesToReadThisIteration) {
+        if (framesDecodedThisIteration < framesToReadThisIteration) {
             break; /* Reached EOF. */
         }
     }
@@ -110,6 +133,155 @@ static ma_uint32 data_mix_pcm(EST_AUDIO_HANDLE handle, EST_AudioDevice *device,
     return totalFramesRead;
 }
 
+// Crossfade length into the next queued sample, 0 for none or a gapless cut
+// length is the one of this sample, as taken when the entry was queued
+static ma_uint64 data_queued_crossfade(EST_AudioSample *sample, ma_uint64 *length)
+{
+    if (sample->attributes.looping) {
+        return 0;
+    }
+
+    // Busy with a queue call, the crossfade is looked at again on the next block
+    std::unique_lock<std::mutex> lock(sample->queueLock, std::try_to_lock);
+    if (!lock.owns_lock() || sample->queue.empty() || sample->queue.front().length == 0) {
+        return 0;
+    }
+
+    *length = sample->queue.front().length;
+    return sample->queue.front().crossfade;
+}
+
+// False while another thread repositions the source, the read would skip the block then too
+static bool data_frames_until_end(EST_AudioSample *sample, ma_uint64 length, ma_uint64 *remaining)
+{
+    std::unique_lock<std::mutex> lock(sample->sourceLock, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+
+    *remaining = sample->cursor < length ? length - sample->cursor : 0;
+    if (sample->attributes.rate != 1.0f) {
+        *remaining = static_cast<ma_uint64>(static_cast<float>(*remaining) / sample->attributes.rate);
+    }
+
+    return true;
+}
+
+// Starts the next queued sample and hands it the rest of the queue
+// isBusy is set when a queue call holds either lock, nothing is handed off then and the caller retries
+static std::shared_ptr<EST_AudioSample> data_begin_next(EST_AudioSample *sample, EST_AUDIO_HANDLE *nextHandle, ma_uint64 fadeFrames, bool *isBusy)
+{
+    *isBusy = false;
+
+    std::unique_lock<std::mutex> lock(sample->queueLock, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        *isBusy = true;
+        return nullptr;
+    }
+
+    while (!sample->queue.empty()) {
+        EST_QueueEntry &entry = sample->queue.front();
+        auto            next = entry.sample;
+
+        if (next->isRemoved) {
+            sample->retired.splice(sample->retired.end(), sample->queue, sample->queue.begin());
+            continue;
+        }
+
+        std::unique_lock<std::mutex> nextLock(next->queueLock, std::try_to_lock);
+        if (!nextLock.owns_lock()) {
+            *isBusy = true;
+            return nullptr;
+        }
+
+        *nextHandle = entry.handle;
+        sample->retired.splice(sample->retired.end(), sample->queue, sample->queue.begin());
+        next->queue.splice(next->queue.begin(), sample->queue);
+
+        next->fade = {};
+        if (fadeFrames > 0) {
+            next->fade.from = 0.0f;
+            next->fade.length = fadeFrames;
+        }
+
+        next->isAtEnd = false;
+        next->isPlaying = true;
+
+        return next;
+    }
+
+    return nullptr;
+}
+
+static void data_mix_voice(EST_AUDIO_HANDLE handle, EST_AudioDevice *device, std::shared_ptr<EST_AudioSample> sample, float *pOutput, ma_uint32 frameCount)
+{
+    int       channels = device->channels;
+    ma_uint32 framesMixed = 0;
+
+    sample->mixGeneration = device->mixGeneration;
+
+    while (framesMixed < frameCount && sample->isPlaying) {
+        ma_uint64 framesToMix = frameCount - framesMixed;
+        ma_uint64 length = 0;
+        ma_uint64 crossfade = data_queued_crossfade(sample.get(), &length);
+
+        if (crossfade > 0) {
+            ma_uint64 remaining = 0;
+            if (!data_frames_until_end(sample.get(), length, &remaining)) {
+                break;
+            }
+
+            if (remaining <= crossfade) {
+                EST_AUDIO_HANDLE nextHandle = 0;
+                bool             isBusy = false;
+                auto             next = data_begin_next(sample.get(), &nextHandle, crossfade, &isBusy);
+
+                if (next) {
+                    sample->fade = {};
+                    sample->fade.to = 0.0f;
+                    sample->fade.length = std::max<ma_uint64>(remaining, 1);
+
+                    data_mix_voice(nextHandle, device, next, pOutput + framesMixed * channels, frameCount - framesMixed);
+                }
+
+                // A busy queue only delays the crossfade, this block plays on and the next one tries again
+                if (!isBusy) {
+                    continue;
+                }
+            } else {
+                // Stop right where the crossfade has to begin
+                framesToMix = std::min(framesToMix, remaining - crossfade);
+            }
+        }
+
+        bool      isAtEnd = false;
+        ma_uint32 framesRead = data_mix_pcm(handle, device, sample, pOutput + framesMixed * channels, static_cast<ma_uint32>(framesToMix), &isAtEnd);
+        framesMixed += framesRead;
+
+        if (isAtEnd) {
+            sample->isAtEnd = true;
+
+            // Gapless handoff, the next sample continues on the very next frame
+            EST_AUDIO_HANDLE nextHandle = 0;
+            bool             isBusy = false;
+            auto             next = data_begin_next(sample.get(), &nextHandle, 0, &isBusy);
+
+            // Stays playing at its end while the queue is busy, the handoff is tried again next block
+            sample->isPlaying = isBusy;
+
+            if (next) {
+                data_mix_voice(nextHandle, device, next, pOutput + framesMixed * channels, frameCount - framesMixed);
+            }
+
+            break;
+        }
+
+        if (framesRead < framesToMix) {
+            break;
+        }
+    }
+}
+
 template <typename ContainerT, typename PredicateT>
 void erase_if_map(ContainerT &items, const PredicateT &predicate)
 {
@@ -131,22 +303,12 @@ static void data_callback(ma_device *pObject, void *pOutput, const void *pInput,
 
     float *pOutputFloat = reinterpret_cast<float *>(pOutput);
 
+    device->mixGeneration++;
+
     for (auto &[handle, sample] : device->samples) {
-        if (sample->isPlaying) {
-            ma_uint32 pcmReaded = data_mix_pcm(handle, device, sample, pOutputFloat, frameCount);
-
-            if (pcmReaded < frameCount) {
-                if (sample->attributes.looping) {
-                    if (sample->rawAudio) {
-                        ma_audio_buffer_seek_to_pcm_frame(&sample->rawAudio->decoder, 0);
-                    } else {
-                        ma_decoder_seek_to_pcm_frame(&sample->decoder, 0);
-                    }
-                } else {
-                    sample->isAtEnd = true;
-                    sample->isPlaying = false;
-                }
-            }
+        // Samples started by a queue handoff were already mixed this block
+        if (sample->isPlaying && sample->mixGeneration != device->mixGeneration) {
+            data_mix_voice(handle, device, sample, pOutputFloat, frameCount);
         }
     }
 
@@ -221,6 +383,8 @@ EST_RESULT EST_DeviceInit(int sampleRate, enum EST_DEVICE_FLAGS flags, EST_DEVIC
 
     device->mutex = std::make_shared<std::mutex>();
 
+    WorkerStart(&device->worker);
+
     *out = reinterpret_cast<EST_DEVICE_HANDLE>(device);
     return EST_OK;
 }
@@ -260,6 +424,7 @@ EST_RESULT EST_DeviceFree(EST_DEVICE_HANDLE devhandle)
     }
 
     ma_device_uninit(&device->device);
+    WorkerStop(&device->worker);
 
     delete device;
     return EST_OK;
@@ -3,12 +3,25 @@
 
 #include <EstAudio.h>
 
+#include "../Common/Analysis.h"
+#include "../Common/DecoderFormat.h"
+#include "../Common/MappedFile.h"
+#include "../Common/PackedPCM.h"
+#include "../Common/ParallelDecode.h"
+#include "../Common/SeekIndex.h"
+#include "../Common/StreamIO.h"
 #include "../third-party/miniaudio/miniaudio_decoders.h"
 #include "../third-party/signalsmith-stretch/signalsmith-stretch.h"
 
 using namespace signalsmith::stretch;
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -49,45 +62,147 @@ struct EST_RawAudio
 
     std::vector<float> PCMData;
     int                PCMSize = 0;
+
+    // Compact frames, read through SamplePackedRead instead of decoder when packed is set
+    enum EST_SAMPLE_STORAGE storage = EST_STORAGE_F32;
+    const unsigned char    *packed = nullptr;
+    int                     channels = 0;
+    ma_uint64               cursor = 0;
+    std::vector<float>      block; // The decoded ADPCM block holding cursor
+    ma_uint64               blockIndex = ~0ull;
+};
+
+// Loop region with the frames around the wrap point decoded ahead of time,
+// so the mixer never has to wait on the decoder when the loop wraps
+struct EST_LoopRegion
+{
+    ma_uint64 start = 0;
+    ma_uint64 end = 0;        // Exclusive, 0 when the stream length is unknown (wrap at EOF)
+    ma_uint64 headFrames = 0;     // Frames in head, decoded from start
+    ma_uint64 tailFrames = 0;     // Frames in tail, crossfaded into end
+    bool      isResident = false; // Head runs right into tail, the whole loop plays from memory without seeking
+
+    std::vector<float> head;
+    std::vector<float> tail;
+};
+
+enum class EST_ReadStage {
+    Source, // Reading from the decoder or raw buffer
+    Tail,   // Reading the crossfaded loop tail
+    Head,   // Reading the loop head while the decoder seeks past it
+    Prime,  // Reading the frames decoded ahead of a queued handoff
+    Seek    // Waiting on the worker to seek the decoder, reads nothing
+};
+
+enum class EST_SeekState {
+    Idle,
+    Requested, // Posted to the worker, not yet started
+    Running    // Worker is seeking the decoder
+};
+
+struct EST_AudioSample;
+
+// Load passes over a decoded sound, shared by every handle playing it
+struct EST_SoundAnalysis
+{
+    ma_uint64 trimmedStart = 0; // Set before the sound is shared
+    ma_uint64 trimmedEnd = 0;
+
+    std::atomic<bool> isQueued = { false };
+    std::atomic<bool> isReady = { false }; // Publishes stats, written once by the worker
+    EST_LoudnessStats stats = {};
+};
+
+struct EST_QueueEntry
+{
+    EST_AUDIO_HANDLE                 handle = 0;
+    std::shared_ptr<EST_AudioSample> sample;
+    ma_uint64                        crossfade = 0; // Frames, 0 for a gapless cut
+    ma_uint64                        length = 0;    // Of the sample playing before, taken when queued, 0 when unknown
+};
+
+// Linear gain ramp applied after the gainer, used for queue crossfades
+struct EST_Fade
+{
+    float     from = 1.0f;
+    float     to = 1.0f;
+    ma_uint64 length = 0; // 0 when idle
+    ma_uint64 position = 0;
 };
 
 struct EST_AudioSample
 {
     int channels = 0;
+    int sampleRate = 0;
 
     bool isInit = false;
     bool isPlaying = false;
     bool isAtEnd = false;
     bool isRemoved = false;
 
-    EST_Attribute                 attributes = {};
-    std::shared_ptr<EST_RawAudio> rawAudio;
+    EST_Attribute                      attributes = {};
+    std::shared_ptr<EST_RawAudio>      rawAudio;
+    std::shared_ptr<void>              storage;          // Keeps memory the source reads from alive (file mapping, owned buffer)
+    std::shared_ptr<EST_SoundAnalysis> analysis;         // Decoded loads with passes only
+    EST_StreamIO                      *stream = nullptr; // Streamed sources, kept alive by storage
 
     ma_decoder           decoder = {};
     ma_panner            panner = {};
     ma_gainer            gainer = {};
     ma_channel_converter converter = {};
 
+    std::vector<ma_ogg_seek_point> seekIndex; // Page index bound to the Ogg backend of decoder, freed after it
+
+    // Where decoder reads from, loop regions decode on a second decoder opened here instead of moving this one
+    std::string           sourcePath; // Empty for memory and callback sources
+    const void           *sourceData = nullptr;
+    size_t                sourceSize = 0;
+    enum EST_AUDIO_FORMAT sourceFormat = EST_FORMAT_AUTO;
+
     std::shared_ptr<EST_AudioResampler> pitch = {};
     std::vector<EST_AudioCallback>      callbacks;
+
+    // Samples to start where this one ends, guarded by queueLock (the mixer only try-locks it).
+    // Lists so the handoff only splices nodes, the mixer never allocates or frees them.
+    std::mutex                queueLock;
+    std::list<EST_QueueEntry> queue;
+    std::list<EST_QueueEntry> retired; // Entries the mixer is done with, freed by the next queue call
+    EST_Fade                  fade = {};
+    ma_uint64                  mixGeneration = 0;
+
+    // Source state, guarded by sourceLock (the mixer only try-locks it)
+    std::mutex                      sourceLock;
+    ma_uint64                       cursor = 0;
+    ma_uint64                       length = 0;
+    EST_ReadStage                   stage = EST_ReadStage::Source;
+    ma_uint64                       stagePosition = 0;
+    std::unique_ptr<EST_LoopRegion> loop;
+    std::vector<float>              prime;
+    ma_uint64                       primeFrames = 0;
+    ma_uint64                       seekTarget = 0;
+    std::atomic<EST_SeekState>      seekState = { EST_SeekState::Idle };
+    bool                            isSeekPosted = false; // The requested seek sits in the worker seek slots
 };
 
 struct EST_AudioDestructor
 {
     inline void operator()(EST_AudioSample *sample) const
     {
-        if (!sample->isInit) {
-            return;
-        }
+        if (sample->isInit) {
+            if (sample->rawAudio) {
+                if (!sample->rawAudio->packed) {
+                    ma_audio_buffer_uninit(&sample->rawAudio->decoder);
+                }
+            } else {
+                ma_decoder_uninit(&sample->decoder);
+            }
 
-        if (sample->rawAudio) {
-            ma_audio_buffer_uninit(&sample->rawAudio->decoder);
-        } else {
-            ma_decoder_uninit(&sample->decoder);
+            ma_channel_converter_uninit(&sample->converter, nullptr);
+            ma_gainer_uninit(&sample->gainer, nullptr);
         }
 
-        ma_channel_converter_uninit(&sample->converter, nullptr);
-        ma_gainer_uninit(&sample->gainer, nullptr);
+        // Releases the storage too, file mappings are unmapped with the last sample
+        delete sample;
     }
 };
 
@@ -95,15 +210,74 @@ struct EST_ResamplerDestructor
 {
     inline void operator()(EST_AudioResampler *sample) const
     {
-        if (!sample->isInit) {
-            return;
+        if (sample->isInit) {
+            ma_resampler_uninit(&sample->resampler, nullptr);
+            sample->processor->reset();
         }
 
-        ma_resampler_uninit(&sample->resampler, nullptr);
-        sample->processor->reset();
+        delete sample;
     }
 };
 
+constexpr size_t kWorkerSeekSlots = 64;
+
+// Single background thread for work that must stay off the audio thread
+struct EST_AudioWorker
+{
+    std::thread                       thread;
+    std::mutex                        mutex;
+    std::condition_variable           signal;
+    std::deque<std::function<void()>> jobs;
+    bool                              isRunning = false;
+
+    // Decoder seeks from the mixer, which can neither lock nor allocate. Only the audio thread
+    // fills slots and only the worker empties them, the indices only ever grow.
+    std::array<std::weak_ptr<EST_AudioSample>, kWorkerSeekSlots> seeks;
+    std::atomic<size_t>                                           seekHead = { 0 }; // Next slot the worker takes
+    std::atomic<size_t>                                           seekTail = { 0 }; // Next slot the mixer fills
+};
+
+// Decoded PCM shared by every handle loaded from the same source, never written after loading
+struct EST_SharedPCM
+{
+    std::vector<float>         frames;
+    std::vector<unsigned char> packed; // Used instead of frames when storage isn't f32
+    enum EST_SAMPLE_STORAGE    storage = EST_STORAGE_F32;
+    ma_uint64                  frameCount = 0;
+    int                        channels = 0;
+    int                        sampleRate = 0;
+
+    std::shared_ptr<EST_SoundAnalysis> analysis; // Null when loaded without passes
+};
+
+// A live file mapping with the size and write time of the file it was made from
+struct EST_MappingEntry
+{
+    std::weak_ptr<EST_MappedFile> file;
+    uintmax_t                     size = 0;
+    int64_t                       time = 0;
+};
+
+struct EST_SamplePoolEntry
+{
+    std::shared_ptr<const EST_SharedPCM> pcm;
+    std::list<std::string>::iterator     order;
+};
+
+// Sounds cached by source, unused ones are evicted least recently used first past the budget
+struct EST_SamplePool
+{
+    std::mutex                                           lock;
+    bool                                                 isEnabled = false;
+    size_t                                               budget = 0; // Bytes
+    size_t                                               bytes = 0;
+    std::unordered_map<std::string, EST_SamplePoolEntry> entries;
+    std::list<std::string>                               order; // Most recently used first
+    ma_uint64                                            hits = 0;
+    ma_uint64                                            misses = 0;
+    ma_uint64                                            evictions = 0;
+};
+
 struct EST_AudioDevice
 {
     int channels = 0;
@@ -119,7 +293,22 @@ struct EST_AudioDevice
     std::string                                                            error;
     std::shared_ptr<std::mutex>                                            mutex;
 
+    // Live file mappings by path, so every handle of a file shares its pages until the file is rewritten
+    std::mutex                                        mappingLock;
+    std::unordered_map<std::string, EST_MappingEntry> mappings;
+    std::string                                       cacheDirectory; // Decoded PCM cache, empty when disabled
+
+    EST_SamplePool   pool;
+    EST_AudioWorker  worker;
+    ma_uint64        mixGeneration = 0;
     EST_AUDIO_HANDLE HandleCounter = 0;
 };
 
+void WorkerStart(EST_AudioWorker *worker);
+void WorkerStop(EST_AudioWorker *worker);
+void WorkerPost(EST_AudioWorker *worker, std::function<void()> job);
+
+// Lock-free, for the audio thread only. Returns false while every slot is taken.
+bool WorkerPostSeek(EST_AudioWorker *worker, const std::shared_ptr<EST_AudioSample> &sample);
+
 #endif
\ No newline at end of file
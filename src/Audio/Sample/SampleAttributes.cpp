@@ -31,6 +31,14 @@ EST_RESULT EST_SampleSetAttribute(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE
             ma_panner_set_pan(&it->panner, value);
             break;
         case EST_ATTRIB_LOOPING:
+            // Whole sample loop unless a region was set, built here so the wrap is free
+            if (value != 0.0f && !it->loop) {
+                EST_RESULT result = SampleBuildLoopRegion(it.get(), 0, 0, 0);
+                if (result != EST_OK) {
+                    return result;
+                }
+            }
+
             it->attributes.looping = value != 0.0f;
             break;
         default:
@@ -219,5 +227,43 @@ EST_RESULT EST_SampleSetGlobalCallback(EST_DEVICE_HANDLE devhandle, est_audio_ca
 
     device->callbacks.push_back(callbackData);
 
+    return EST_OK;
+}
+
+EST_RESULT EST_SampleGetAnalysis(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle, est_sample_analysis *analysis)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!analysis) {
+        EST_SetError("'analysis' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto it = GetSample(device, handle);
+    if (!it) {
+        EST_SetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!it->analysis) {
+        EST_SetError("Sample was not loaded decoded");
+        return EST_ERROR_INVALID_OPERATION;
+    }
+
+    const EST_SoundAnalysis &source = *it->analysis;
+    bool                     isReady = source.isReady.load(std::memory_order_acquire);
+
+    analysis->isReady = isReady ? EST_TRUE : EST_FALSE;
+    analysis->peak = isReady ? source.stats.peak : 0.0f;
+    analysis->rms = isReady ? source.stats.rms : 0.0f;
+    analysis->loudness = isReady ? source.stats.loudness : 0.0f;
+    analysis->trimmedStart = static_cast<long long>(source.trimmedStart);
+    analysis->trimmedEnd = static_cast<long long>(source.trimmedEnd);
+
     return EST_OK;
 }
\ No newline at end of file
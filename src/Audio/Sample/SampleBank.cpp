@@ -0,0 +1,496 @@
+#include "SampleInternal.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    constexpr char     kBankMagic[8] = { 'E', 'S', 'T', 'B', 'A', 'N', 'K', '1' };
+    constexpr uint32_t kBankVersion = 1;
+    constexpr uint32_t kBankFormatPCM = 0x100; // Otherwise the entry holds the EST_AUDIO_FORMAT of the stored file
+    constexpr uint64_t kBankAlignment = 64;
+    constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+    constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+    struct EST_BankHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t entryCount;
+        uint64_t indexOffset;
+        uint64_t reserved;
+    };
+
+    // Sorted by nameHash, payloads start on kBankAlignment boundaries
+    struct EST_BankEntry
+    {
+        uint64_t nameHash;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t frameCount; // 0 when the file is stored as is
+        uint64_t loopStart;
+        uint64_t loopEnd;
+        uint32_t format;
+        uint32_t channels;
+        uint32_t sampleRate;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(EST_BankHeader) == 32, "bank header layout");
+    static_assert(sizeof(EST_BankEntry) == 64, "bank entry layout");
+
+    struct EST_SoundBank
+    {
+        std::shared_ptr<EST_MappedFile> file;
+        std::vector<EST_BankEntry>      entries;
+    };
+
+    // One entry waiting to be written
+    struct EST_BankPayload
+    {
+        EST_BankEntry              entry = {};
+        std::vector<unsigned char> data;
+    };
+} // namespace
+
+static uint64_t bank_hash(const char *name)
+{
+    uint64_t hash = kFnvOffset;
+    for (const char *c = name; *c; c++) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * kFnvPrime;
+    }
+
+    return hash;
+}
+
+static bool bank_read_file(const char *path, std::vector<unsigned char> &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+// Keeps the file as it is, only the native rate is read so loop points can follow the device rate
+static EST_RESULT bank_pack_file(const est_bank_entry &source, EST_BankPayload *payload)
+{
+    if (!bank_read_file(source.path, payload->data)) {
+        EST_SetError("Failed to read audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    enum EST_AUDIO_FORMAT format = DetectFormat(payload->data.data(), payload->data.size(), source.path);
+
+    ma_decoder        decoder;
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+
+    if (DecoderInitMemory(payload->data.data(), payload->data.size(), source.path, &config, format, &decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    payload->entry.format = static_cast<uint32_t>(format);
+    payload->entry.channels = decoder.outputChannels;
+    payload->entry.sampleRate = decoder.outputSampleRate;
+
+    ma_decoder_uninit(&decoder);
+    return EST_OK;
+}
+
+static EST_RESULT bank_pack_pcm(const est_bank_entry &source, int sampleRate, int channels, EST_BankPayload *payload)
+{
+    EST_DecodeSource decode;
+    decode.path = source.path;
+
+    std::vector<float> frames;
+    ma_uint32          sourceChannels = 0;
+    ma_uint32          sourceRate = 0;
+
+    ma_result result = DecodeParallel(decode, 0, frames, &sourceChannels, &sourceRate);
+    if (result == MA_OUT_OF_MEMORY) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (result != MA_SUCCESS || sourceChannels == 0 || frames.empty()) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    ma_uint32 targetRate = sampleRate > 0 ? static_cast<ma_uint32>(sampleRate) : sourceRate;
+    ma_uint32 targetChannels = channels > 0 ? static_cast<ma_uint32>(channels) : sourceChannels;
+    ma_uint64 frameCount = frames.size() / sourceChannels;
+
+    if (targetRate != sourceRate || targetChannels != sourceChannels) {
+        ma_uint64 convertedCount = ma_convert_frames(nullptr, 0, ma_format_f32, targetChannels, targetRate, nullptr, frameCount, ma_format_f32, sourceChannels, sourceRate);
+
+        payload->data.resize(convertedCount * targetChannels * sizeof(float));
+        frameCount = ma_convert_frames(payload->data.data(), convertedCount, ma_format_f32, targetChannels, targetRate, frames.data(), frameCount, ma_format_f32, sourceChannels, sourceRate);
+        payload->data.resize(frameCount * targetChannels * sizeof(float));
+    } else {
+        payload->data.resize(frames.size() * sizeof(float));
+        std::memcpy(payload->data.data(), frames.data(), payload->data.size());
+    }
+
+    if (frameCount == 0) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Loop points were given in frames of the file
+    payload->entry.loopStart = payload->entry.loopStart * targetRate / sourceRate;
+    payload->entry.loopEnd = payload->entry.loopEnd * targetRate / sourceRate;
+
+    payload->entry.format = kBankFormatPCM;
+    payload->entry.frameCount = frameCount;
+    payload->entry.channels = targetChannels;
+    payload->entry.sampleRate = targetRate;
+
+    return EST_OK;
+}
+
+static bool bank_write(const char *output, std::vector<EST_BankPayload> &payloads)
+{
+    EST_BankHeader header = {};
+    std::memcpy(header.magic, kBankMagic, sizeof(kBankMagic));
+    header.version = kBankVersion;
+    header.entryCount = static_cast<uint32_t>(payloads.size());
+    header.indexOffset = sizeof(EST_BankHeader);
+
+    uint64_t offset = header.indexOffset + payloads.size() * sizeof(EST_BankEntry);
+    for (auto &payload : payloads) {
+        offset = (offset + kBankAlignment - 1) / kBankAlignment * kBankAlignment;
+        payload.entry.offset = offset;
+        payload.entry.size = payload.data.size();
+        offset += payload.data.size();
+    }
+
+    std::filesystem::path target(output);
+    std::filesystem::path temporary = target;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        for (const auto &payload : payloads) {
+            file.write(reinterpret_cast<const char *>(&payload.entry), sizeof(payload.entry));
+        }
+
+        static const char padding[kBankAlignment] = {};
+        uint64_t          position = header.indexOffset + payloads.size() * sizeof(EST_BankEntry);
+
+        for (const auto &payload : payloads) {
+            file.write(padding, static_cast<std::streamsize>(payload.entry.offset - position));
+            file.write(reinterpret_cast<const char *>(payload.data.data()), static_cast<std::streamsize>(payload.data.size()));
+            position = payload.entry.offset + payload.entry.size;
+        }
+
+        if (!file) {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
+
+EST_RESULT EST_BankBuild(const est_bank_entry *entries, int count, int sampleRate, int channels, enum EST_BANK_FLAGS flags, const char *output)
+{
+    if (!entries || count <= 0 || !output || sampleRate < 0 || channels < 0) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        std::vector<EST_BankPayload> payloads(static_cast<size_t>(count));
+
+        for (int i = 0; i < count; i++) {
+            const est_bank_entry &source = entries[i];
+            EST_BankPayload      &payload = payloads[i];
+
+            if (!source.path || source.loopStart < 0 || source.loopEnd < 0 || (source.loopEnd > 0 && source.loopStart >= source.loopEnd)) {
+                EST_SetError("Invalid bank entry");
+                return EST_ERROR_INVALID_ARGUMENT;
+            }
+
+            payload.entry.nameHash = bank_hash(source.name ? source.name : source.path);
+            payload.entry.loopStart = static_cast<uint64_t>(source.loopStart);
+            payload.entry.loopEnd = static_cast<uint64_t>(source.loopEnd);
+
+            EST_RESULT result = (flags & EST_BANK_DECODED)
+                                    ? bank_pack_pcm(source, sampleRate, channels, &payload)
+                                    : bank_pack_file(source, &payload);
+
+            if (result != EST_OK) {
+                return result;
+            }
+        }
+
+        std::sort(payloads.begin(), payloads.end(), [](const EST_BankPayload &a, const EST_BankPayload &b) {
+            return a.entry.nameHash < b.entry.nameHash;
+        });
+
+        for (size_t i = 1; i < payloads.size(); i++) {
+            if (payloads[i].entry.nameHash == payloads[i - 1].entry.nameHash) {
+                EST_SetError("Duplicated name in bank");
+                return EST_ERROR_INVALID_ARGUMENT;
+            }
+        }
+
+        if (!bank_write(output, payloads)) {
+            EST_SetError("Failed to write bank file");
+            return EST_ERROR_INVALID_OPERATION;
+        }
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    return EST_OK;
+}
+
+EST_RESULT EST_BankOpen(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_MAP_FLAGS flags, EST_BANK_HANDLE *bank)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!path || !bank) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto file = SampleMapFile(device, path, flags);
+    if (!file) {
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_BankHeader header;
+    if (file->size < sizeof(header)) {
+        EST_SetError("Invalid bank file");
+        return EST_ERROR_INVALID_FORMAT;
+    }
+
+    std::memcpy(&header, file->data, sizeof(header));
+
+    if (std::memcmp(header.magic, kBankMagic, sizeof(kBankMagic)) != 0 ||
+        header.version != kBankVersion ||
+        header.indexOffset > file->size ||
+        header.entryCount > (file->size - header.indexOffset) / sizeof(EST_BankEntry)) {
+        EST_SetError("Invalid bank file");
+        return EST_ERROR_INVALID_FORMAT;
+    }
+
+    EST_SoundBank *instance = nullptr;
+
+    try {
+        instance = new EST_SoundBank;
+        instance->file = file;
+        instance->entries.resize(header.entryCount);
+    } catch (std::bad_alloc &alloc) {
+        delete instance;
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    std::memcpy(instance->entries.data(), file->data + header.indexOffset, header.entryCount * sizeof(EST_BankEntry));
+
+    // Payloads are checked once here so loads only trust the index
+    for (const auto &entry : instance->entries) {
+        bool isValid = entry.offset <= file->size &&
+                       entry.size <= file->size - entry.offset &&
+                       entry.size > 0 &&
+                       entry.channels > 0 &&
+                       entry.sampleRate > 0;
+
+        if (isValid && entry.format == kBankFormatPCM) {
+            isValid = entry.offset % sizeof(float) == 0 &&
+                      entry.frameCount > 0 &&
+                      entry.frameCount <= entry.size / (sizeof(float) * entry.channels);
+        }
+
+        if (!isValid) {
+            delete instance;
+            EST_SetError("Invalid bank file");
+            return EST_ERROR_INVALID_FORMAT;
+        }
+    }
+
+    *bank = reinterpret_cast<EST_BANK_HANDLE>(instance);
+    return EST_OK;
+}
+
+EST_RESULT EST_BankGetCount(EST_BANK_HANDLE bank, int *count)
+{
+    auto instance = reinterpret_cast<EST_SoundBank *>(bank);
+
+    if (!instance || !count) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    *count = static_cast<int>(instance->entries.size());
+    return EST_OK;
+}
+
+static const EST_BankEntry *bank_find(const EST_SoundBank *bank, const char *name)
+{
+    uint64_t hash = bank_hash(name);
+
+    auto it = std::lower_bound(bank->entries.begin(), bank->entries.end(), hash, [](const EST_BankEntry &entry, uint64_t value) {
+        return entry.nameHash < value;
+    });
+
+    return it != bank->entries.end() && it->nameHash == hash ? &*it : nullptr;
+}
+
+// The sample is registered already, free it again when the region doesn't fit
+static EST_RESULT bank_apply_loop(EST_AudioDevice *device, EST_AudioSample *sample, ma_uint64 start, ma_uint64 end, EST_AUDIO_HANDLE handle)
+{
+    EST_RESULT result = SampleBuildLoopRegion(sample, start, end, 0);
+    if (result != EST_OK) {
+        EST_SampleFree(device, handle);
+    }
+
+    return result;
+}
+
+static EST_RESULT bank_load_entry(EST_AudioDevice *device, const EST_SoundBank *bank, const EST_BankEntry &entry, EST_AUDIO_HANDLE *handle)
+{
+    const unsigned char *data = bank->file->data + entry.offset;
+
+    if (entry.format == kBankFormatPCM) {
+        EST_MappedPCM pcm;
+        pcm.file = bank->file;
+        pcm.frames = reinterpret_cast<const float *>(data);
+        pcm.frameCount = entry.frameCount;
+        pcm.channels = static_cast<int>(entry.channels);
+        pcm.sampleRate = static_cast<int>(entry.sampleRate);
+
+        EST_RESULT result = SampleLoadMappedPCM(device, pcm, handle);
+        if (result != EST_OK || entry.loopEnd == 0) {
+            return result;
+        }
+
+        return bank_apply_loop(device, GetSample(device, *handle).get(), entry.loopStart, entry.loopEnd, *handle);
+    }
+
+    std::shared_ptr<EST_AudioSample> sample;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    sample->storage = bank->file;
+
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, device->device.sampleRate);
+    auto              format = static_cast<enum EST_AUDIO_FORMAT>(entry.format);
+
+    if (DecoderInitMemory(data, entry.size, nullptr, &config, format, &sample->decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    SampleBuildSeekIndex(device, sample, nullptr, data, entry.size);
+
+    EST_RESULT result = InternalInit(device, sample, sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate, handle);
+    if (result != EST_OK || entry.loopEnd == 0) {
+        return result;
+    }
+
+    // The decoder outputs at the device rate, the stored loop points are at the file rate
+    ma_uint64 outputRate = sample->decoder.outputSampleRate;
+    return bank_apply_loop(
+        device,
+        sample.get(),
+        entry.loopStart * outputRate / entry.sampleRate,
+        entry.loopEnd * outputRate / entry.sampleRate,
+        *handle);
+}
+
+EST_RESULT EST_BankLoadSamples(EST_DEVICE_HANDLE devhandle, EST_BANK_HANDLE bank, const char **names, int count, EST_AUDIO_HANDLE *handles)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+    auto instance = reinterpret_cast<EST_SoundBank *>(bank);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!instance || !names || count <= 0 || !handles) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Resolve every name first so a typo doesn't leave half the samples created
+    std::vector<const EST_BankEntry *> found;
+
+    try {
+        found.resize(static_cast<size_t>(count));
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < count; i++) {
+        found[i] = names[i] ? bank_find(instance, names[i]) : nullptr;
+        if (!found[i]) {
+            EST_SetError("Sound not found in bank");
+            return EST_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        EST_RESULT result = bank_load_entry(device, instance, *found[i], &handles[i]);
+        if (result == EST_OK) {
+            continue;
+        }
+
+        for (int j = 0; j < i; j++) {
+            EST_SampleFree(devhandle, handles[j]);
+        }
+
+        return result;
+    }
+
+    return EST_OK;
+}
+
+EST_RESULT EST_BankLoadSample(EST_DEVICE_HANDLE devhandle, EST_BANK_HANDLE bank, const char *name, EST_AUDIO_HANDLE *handle)
+{
+    return EST_BankLoadSamples(devhandle, bank, &name, 1, handle);
+}
+
+EST_RESULT EST_BankFree(EST_BANK_HANDLE bank)
+{
+    auto instance = reinterpret_cast<EST_SoundBank *>(bank);
+
+    if (!instance) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    delete instance;
+    return EST_OK;
+}
\ No newline at end of file
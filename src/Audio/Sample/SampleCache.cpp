@@ -0,0 +1,239 @@
+#include "SampleInternal.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    constexpr char      kCacheMagic[8] = { 'E', 'S', 'T', 'P', 'C', 'M', '0', '1' };
+    constexpr uint32_t  kCacheVersion = 1;
+    constexpr size_t    kHashSampleBytes = 64 * 1024; // Hashed from both ends of the source
+    constexpr uint64_t  kFnvOffset = 14695981039346656037ull;
+    constexpr uint64_t  kFnvPrime = 1099511628211ull;
+    constexpr const char *kCacheExtension = ".estpcm";
+
+    // Followed by the interleaved f32 frames, 64 bytes keeps them aligned in the mapping
+    struct EST_CacheHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t channels;
+        uint32_t sampleRate;
+        uint32_t reserved;
+        uint64_t frameCount;
+        uint64_t sourceSize;
+        int64_t  sourceTime;
+        uint64_t sourceHash;
+        uint8_t  padding[8];
+    };
+
+    static_assert(sizeof(EST_CacheHeader) == 64, "cache header must keep the frames aligned");
+
+    struct EST_SourceStamp
+    {
+        std::string key; // Canonical path
+        uint64_t    size = 0;
+        int64_t     time = 0;
+        uint64_t    hash = 0;
+    };
+} // namespace
+
+static uint64_t cache_hash(uint64_t hash, const void *data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+
+    return hash;
+}
+
+// Size and modification time catch edits, the sampled content hash catches copies over the file
+static bool cache_stamp(const char *path, EST_SourceStamp *stamp)
+{
+    std::error_code error;
+
+    stamp->key = std::filesystem::weakly_canonical(path, error).string();
+    if (error) {
+        return false;
+    }
+
+    stamp->size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+
+    stamp->time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    if (error) {
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> buffer(kHashSampleBytes);
+    uint64_t          hash = cache_hash(kFnvOffset, &stamp->size, sizeof(stamp->size));
+
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hash = cache_hash(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+
+    if (stamp->size > kHashSampleBytes * 2) {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(stamp->size - kHashSampleBytes));
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash = cache_hash(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+
+    stamp->hash = hash;
+    return true;
+}
+
+static std::filesystem::path cache_path(const std::string &directory, const EST_SourceStamp &stamp, int channels, int sampleRate)
+{
+    char name[64];
+    std::snprintf(
+        name,
+        sizeof(name),
+        "%016llx_%d_%d",
+        static_cast<unsigned long long>(cache_hash(kFnvOffset, stamp.key.data(), stamp.key.size())),
+        sampleRate,
+        channels);
+
+    return std::filesystem::path(directory) / (std::string(name) + kCacheExtension);
+}
+
+static std::string cache_directory(EST_AudioDevice *device)
+{
+    std::lock_guard<std::mutex> lock(device->mappingLock);
+    return device->cacheDirectory;
+}
+
+bool SampleCacheLookup(EST_AudioDevice *device, const char *path, EST_MappedPCM *cached)
+{
+    std::string directory = cache_directory(device);
+    if (directory.empty() || !path) {
+        return false;
+    }
+
+    int channels = device->channels;
+    int sampleRate = static_cast<int>(device->device.sampleRate);
+
+    EST_SourceStamp stamp;
+    try {
+        if (!cache_stamp(path, &stamp)) {
+            return false;
+        }
+    } catch (std::bad_alloc &) {
+        return false;
+    }
+
+    std::error_code error;
+    auto            file = cache_path(directory, stamp, channels, sampleRate);
+    if (!std::filesystem::exists(file, error)) {
+        return false;
+    }
+
+    auto mapping = SampleMapFile(device, file.string().c_str(), EST_MAP_DEFAULT);
+    if (!mapping || mapping->size < sizeof(EST_CacheHeader)) {
+        return false;
+    }
+
+    EST_CacheHeader header;
+    std::memcpy(&header, mapping->data, sizeof(header));
+
+    bool isValid = std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0 &&
+                   header.version == kCacheVersion &&
+                   header.channels == static_cast<uint32_t>(channels) &&
+                   header.sampleRate == static_cast<uint32_t>(sampleRate) &&
+                   header.sourceSize == stamp.size &&
+                   header.sourceTime == stamp.time &&
+                   header.sourceHash == stamp.hash &&
+                   header.frameCount > 0 &&
+                   header.frameCount <= (mapping->size - sizeof(header)) / (sizeof(float) * channels);
+
+    if (!isValid) {
+        return false;
+    }
+
+    cached->file = mapping;
+    cached->frames = reinterpret_cast<const float *>(mapping->data + sizeof(header));
+    cached->frameCount = header.frameCount;
+    cached->channels = channels;
+    cached->sampleRate = sampleRate;
+
+    return true;
+}
+
+void SampleCacheStore(EST_AudioDevice *device, const char *path, const float *frames, ma_uint64 frameCount, int channels, int sampleRate)
+{
+    std::string directory = cache_directory(device);
+    if (directory.empty() || !path || frameCount == 0) {
+        return;
+    }
+
+    // A failed write only costs the next load a decode, never fail the load over it
+    try {
+        EST_SourceStamp stamp;
+        if (!cache_stamp(path, &stamp)) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        EST_CacheHeader header = {};
+        std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.channels = static_cast<uint32_t>(channels);
+        header.sampleRate = static_cast<uint32_t>(sampleRate);
+        header.frameCount = frameCount;
+        header.sourceSize = stamp.size;
+        header.sourceTime = stamp.time;
+        header.sourceHash = stamp.hash;
+
+        auto target = cache_path(directory, stamp, channels, sampleRate);
+        auto temporary = target;
+        temporary += ".tmp";
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(frames), static_cast<std::streamsize>(frameCount * channels * sizeof(float)));
+
+            if (!file) {
+                file.close();
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+
+        // Readers only ever see a complete file
+        std::filesystem::rename(temporary, target, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+        }
+    } catch (std::exception &) {
+    }
+}
+
+EST_RESULT EST_DeviceSetCacheDirectory(EST_DEVICE_HANDLE devhandle, const char *path)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(device->mappingLock);
+        device->cacheDirectory = path ? path : "";
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    return EST_OK;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "SampleInternal.h"
+#include <cmath>
 
 EST_RESULT InternalInit(EST_DEVICE_HANDLE devhandle, std::shared_ptr<EST_AudioSample> sample, ma_format format, int channels, int sampleRate, EST_AUDIO_HANDLE *handle)
 {
@@ -56,6 +57,7 @@ EST_RESULT InternalInit(EST_DEVICE_HANDLE devhandle, std::shared_ptr<EST_AudioSa
     pitch->isInit = true;
     sample->isInit = true;
     sample->channels = channels;
+    sample->sampleRate = sampleRate;
     sample->pitch = pitch;
 
     std::lock_guard<std::mutex> lock(*device->mutex.get());
@@ -69,6 +71,11 @@ EST_RESULT InternalInit(EST_DEVICE_HANDLE devhandle, std::shared_ptr<EST_AudioSa
 }
 
 EST_RESULT EST_SampleLoad(EST_DEVICE_HANDLE devhandle, const char *path, EST_AUDIO_HANDLE *handle)
+{
+    return EST_SampleLoadWithFormat(devhandle, path, EST_FORMAT_AUTO, handle);
+}
+
+EST_RESULT EST_SampleLoadWithFormat(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle)
 {
     auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
 
@@ -77,27 +84,63 @@ EST_RESULT EST_SampleLoad(EST_DEVICE_HANDLE devhandle, const char *path, EST_AUD
         return EST_ERROR;
     }
 
+    // Decoded before with caching enabled, skip the decoder entirely
+    EST_MappedPCM cached;
+    if (device && SampleCacheLookup(device, path, &cached)) {
+        return SampleLoadMappedPCM(device, cached, handle);
+    }
+
     std::shared_ptr<EST_AudioSample> sample;
 
     try {
         sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+        sample->sourcePath = path;
     } catch (std::bad_alloc &alloc) {
         EST_SetError(alloc.what());
         return EST_ERROR_OUT_OF_MEMORY;
     }
 
+    sample->sourceFormat = format;
+
     ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, 44100);
 
-    ma_decoding_backend_vtable *pCustomBackendVTables[] = {
-        &g_ma_decoding_backend_vtable_libvorbis,
-        &g_ma_decoding_backend_vtable_libopus
-    };
+    if (DecoderInitFile(path, &config, format, &sample->decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_RESULT result = InternalInit(device, sample, sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate, handle);
+    if (result == EST_OK) {
+        SampleBuildSeekIndex(device, sample, path, nullptr, 0);
+    }
+
+    return result;
+}
+
+// The stream is the storage, it outlives the decoder and closes the source last
+static EST_RESULT sample_load_stream(EST_AudioDevice *device, std::shared_ptr<EST_StreamIO> stream, const char *path, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle)
+{
+    std::shared_ptr<EST_AudioSample> sample;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
 
-    config.pCustomBackendUserData = NULL;
-    config.ppCustomBackendVTables = pCustomBackendVTables;
-    config.customBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
+        // Callback sources can't be opened a second time
+        if (stream->file) {
+            sample->sourcePath = path;
+        }
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    sample->storage = stream;
+    sample->stream = stream.get();
+    sample->sourceFormat = format;
 
-    if (ma_decoder_init_file(path, &config, &sample->decoder) != MA_SUCCESS) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, device->device.sampleRate);
+
+    if (DecoderInitVFS(StreamGetVFS(stream.get()), path, &config, format, &sample->decoder) != MA_SUCCESS) {
         EST_SetError("Failed to load audio file");
         return EST_ERROR_INVALID_ARGUMENT;
     }
@@ -105,11 +148,98 @@ EST_RESULT EST_SampleLoad(EST_DEVICE_HANDLE devhandle, const char *path, EST_AUD
     return InternalInit(device, sample, sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate, handle);
 }
 
-EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE devhandle, const void *data, int size, EST_AUDIO_HANDLE *handle)
+EST_RESULT EST_SampleLoadCallbacks(EST_DEVICE_HANDLE devhandle, const est_io_callbacks *io, enum EST_AUDIO_FORMAT format, enum EST_IO_FLAGS flags, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!io) {
+        EST_SetError("'io' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto stream = StreamOpenCallbacks(io, flags);
+    if (!stream) {
+        EST_SetError("Failed to open stream");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Only names the source to miniaudio, the format comes from the leading bytes
+    return sample_load_stream(device, stream, "stream", format, handle);
+}
+
+EST_RESULT EST_SampleLoadStream(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_AUDIO_FORMAT format, enum EST_IO_FLAGS flags, EST_AUDIO_HANDLE *handle)
 {
     auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
 
-    if (!data) {
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!path) {
+        EST_SetError("'path' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto stream = StreamOpenFile(path, flags);
+    if (!stream) {
+        EST_SetError("Failed to open file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_RESULT result = sample_load_stream(device, stream, path, format, handle);
+    if (result == EST_OK) {
+        SampleBuildSeekIndex(device, GetSample(device, *handle), path, nullptr, 0);
+    }
+
+    return result;
+}
+
+namespace {
+    // Caller memory handed over through the owned load variants
+    struct EST_UserBuffer
+    {
+        void                *data = nullptr;
+        est_release_callback release = nullptr;
+        void                *userData = nullptr;
+    };
+
+    struct EST_UserBufferDestructor
+    {
+        inline void operator()(EST_UserBuffer *buffer) const
+        {
+            if (buffer->release) {
+                buffer->release(buffer->data, buffer->userData);
+            }
+
+            delete buffer;
+        }
+    };
+} // namespace
+
+// Takes over the caller's buffer, the release callback runs exactly once even when this fails
+static std::shared_ptr<void> sample_adopt_buffer(void *data, est_release_callback release, void *userData)
+{
+    try {
+        return std::shared_ptr<EST_UserBuffer>(new EST_UserBuffer{ data, release, userData }, EST_UserBufferDestructor{});
+    } catch (std::bad_alloc &alloc) {
+        if (release) {
+            release(data, userData);
+        }
+
+        EST_SetError(alloc.what());
+        return nullptr;
+    }
+}
+
+static EST_RESULT sample_load_memory(EST_AudioDevice *device, const void *data, int size, enum EST_AUDIO_FORMAT format, std::shared_ptr<void> storage, EST_AUDIO_HANDLE *handle)
+{
+    if (!data || size <= 0) {
         EST_SetError("'data' is nullptr");
         return EST_ERROR;
     }
@@ -123,40 +253,37 @@ EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE devhandle, const void *data, i
         return EST_ERROR_OUT_OF_MEMORY;
     }
 
-    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, 44100);
-
-    ma_decoding_backend_vtable *pCustomBackendVTables[] = {
-        &g_ma_decoding_backend_vtable_libvorbis,
-        &g_ma_decoding_backend_vtable_libopus
-    };
+    // The decoder reads straight from data for the whole lifetime of the sample
+    sample->storage = std::move(storage);
+    sample->sourceData = data;
+    sample->sourceSize = static_cast<size_t>(size);
+    sample->sourceFormat = format;
 
-    config.pCustomBackendUserData = NULL;
-    config.ppCustomBackendVTables = pCustomBackendVTables;
-    config.customBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, 44100);
 
-    if (ma_decoder_init_memory(data, size, &config, &sample->decoder) != MA_SUCCESS) {
+    if (DecoderInitMemory(data, size, nullptr, &config, format, &sample->decoder) != MA_SUCCESS) {
         EST_SetError("Failed to load audio file");
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
+    SampleBuildSeekIndex(device, sample, nullptr, data, static_cast<size_t>(size));
+
     return InternalInit(device, sample, sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate, handle);
 }
 
-EST_RESULT EST_SampleLoadRawPCM(EST_DEVICE_HANDLE devhandle, const void *data, int pcmSize, int channels, int sampleRate, EST_AUDIO_HANDLE *handle)
+static EST_RESULT sample_load_raw(EST_AudioDevice *device, std::shared_ptr<EST_RawAudio> rawAudio, const float *data, int pcmSize, int channels, int sampleRate, std::shared_ptr<void> storage, std::shared_ptr<EST_SoundAnalysis> analysis, EST_AUDIO_HANDLE *handle)
 {
-    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
-
-    if (!data) {
+    if (!data || pcmSize <= 0 || channels <= 0 || sampleRate <= 0) {
+        EST_SetError("Invalid arguments");
         return EST_ERROR_INVALID_DATA;
     }
 
-    int expectedDataSize = pcmSize * channels;
-
-    std::shared_ptr<EST_RawAudio>    rawAudio;
     std::shared_ptr<EST_AudioSample> sample;
+
     try {
-        rawAudio = std::make_shared<EST_RawAudio>();
-        rawAudio->PCMData.resize(expectedDataSize);
+        if (!rawAudio) {
+            rawAudio = std::make_shared<EST_RawAudio>();
+        }
 
         sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
     } catch (const std::bad_alloc &) {
@@ -164,29 +291,519 @@ EST_RESULT EST_SampleLoadRawPCM(EST_DEVICE_HANDLE devhandle, const void *data, i
         return EST_ERROR_OUT_OF_MEMORY;
     }
 
-    // memcpy(&rawAudio->PCMData[0], data, expectedDataSize * sizeof(float));
-
-    const float *pFloatData = static_cast<const float *>(data);
-    std::copy(pFloatData, pFloatData + expectedDataSize, &rawAudio->PCMData[0]);
-    rawAudio->PCMSize = pcmSize;
+    sample->storage = std::move(storage);
+    sample->analysis = std::move(analysis);
 
     ma_audio_buffer_config config = ma_audio_buffer_config_init(
         ma_format_f32,
         channels,
         pcmSize,
-        &rawAudio->PCMData[0],
+        data,
         nullptr);
 
+    // ma_audio_buffer_init references data without copying it
     auto result = ma_audio_buffer_init(&config, &rawAudio->decoder);
     if (result != MA_SUCCESS) {
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
+    rawAudio->PCMSize = pcmSize;
     sample->rawAudio = rawAudio;
 
     return InternalInit(device, sample, ma_format_f32, channels, sampleRate, handle);
 }
 
+// Compact frames skip the audio buffer, the mixer unpacks them through SamplePackedRead
+static EST_RESULT sample_load_packed(EST_AudioDevice *device, const std::shared_ptr<const EST_SharedPCM> &pcm, EST_AUDIO_HANDLE *handle)
+{
+    std::shared_ptr<EST_AudioSample> sample;
+    std::shared_ptr<EST_RawAudio>    rawAudio;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+        rawAudio = std::make_shared<EST_RawAudio>();
+
+        if (pcm->storage == EST_STORAGE_ADPCM) {
+            rawAudio->block.resize(kAdpcmBlockFrames * pcm->channels);
+        }
+    } catch (const std::bad_alloc &) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    rawAudio->storage = pcm->storage;
+    rawAudio->packed = pcm->packed.data();
+    rawAudio->channels = pcm->channels;
+    rawAudio->PCMSize = static_cast<int>(pcm->frameCount);
+
+    sample->rawAudio = rawAudio;
+    sample->storage = std::const_pointer_cast<EST_SharedPCM>(pcm);
+    sample->analysis = pcm->analysis;
+
+    return InternalInit(device, sample, ma_format_f32, pcm->channels, pcm->sampleRate, handle);
+}
+
+// Every handle gets its own cursor over the same frames
+static EST_RESULT sample_load_shared(EST_AudioDevice *device, const std::shared_ptr<const EST_SharedPCM> &pcm, EST_AUDIO_HANDLE *handle)
+{
+    if (pcm->frameCount > static_cast<ma_uint64>(INT32_MAX)) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (pcm->storage != EST_STORAGE_F32) {
+        return sample_load_packed(device, pcm, handle);
+    }
+
+    return sample_load_raw(
+        device,
+        nullptr,
+        pcm->frames.data(),
+        static_cast<int>(pcm->frameCount),
+        pcm->channels,
+        pcm->sampleRate,
+        std::const_pointer_cast<EST_SharedPCM>(pcm),
+        pcm->analysis,
+        handle);
+}
+
+EST_RESULT EST_SampleLoadMemory(EST_DEVICE_HANDLE devhandle, const void *data, int size, EST_AUDIO_HANDLE *handle)
+{
+    return EST_SampleLoadMemoryBorrowed(devhandle, data, size, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryWithFormat(EST_DEVICE_HANDLE devhandle, const void *data, int size, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    return sample_load_memory(device, data, size, format, nullptr, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryBorrowed(EST_DEVICE_HANDLE devhandle, const void *data, int size, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    return sample_load_memory(device, data, size, EST_FORMAT_AUTO, nullptr, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryOwned(EST_DEVICE_HANDLE devhandle, void *data, int size, est_release_callback release, void *userData, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    auto storage = sample_adopt_buffer(data, release, userData);
+    if (!storage) {
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    return sample_load_memory(device, data, size, EST_FORMAT_AUTO, std::move(storage), handle);
+}
+
+EST_RESULT EST_SampleLoadRawPCM(EST_DEVICE_HANDLE devhandle, const void *data, int pcmSize, int channels, int sampleRate, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!data || pcmSize <= 0 || channels <= 0) {
+        return EST_ERROR_INVALID_DATA;
+    }
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    size_t                               expectedDataSize = static_cast<size_t>(pcmSize) * channels;
+    std::shared_ptr<const EST_SharedPCM> pcm;
+    std::string                          key;
+
+    try {
+        key = SamplePoolDataKey(device, "pcm", data, expectedDataSize * sizeof(float));
+        if (!key.empty()) {
+            key += ":" + std::to_string(channels) + ":" + std::to_string(sampleRate);
+        }
+
+        pcm = SamplePoolFind(device, key);
+        if (!pcm) {
+            auto copy = std::make_shared<EST_SharedPCM>();
+
+            const float *pFloatData = static_cast<const float *>(data);
+            copy->frames.assign(pFloatData, pFloatData + expectedDataSize);
+            copy->frameCount = static_cast<ma_uint64>(pcmSize);
+            copy->channels = channels;
+            copy->sampleRate = sampleRate;
+
+            pcm = SamplePoolInsert(device, key, std::move(copy));
+        }
+    } catch (const std::bad_alloc &) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    return sample_load_shared(device, pcm, handle);
+}
+
+EST_RESULT EST_SampleLoadRawPCMBorrowed(EST_DEVICE_HANDLE devhandle, const float *data, int pcmSize, int channels, int sampleRate, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    return sample_load_raw(device, nullptr, data, pcmSize, channels, sampleRate, nullptr, nullptr, handle);
+}
+
+EST_RESULT EST_SampleLoadRawPCMOwned(EST_DEVICE_HANDLE devhandle, float *data, int pcmSize, int channels, int sampleRate, est_release_callback release, void *userData, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    auto storage = sample_adopt_buffer(data, release, userData);
+    if (!storage) {
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    return sample_load_raw(device, nullptr, data, pcmSize, channels, sampleRate, std::move(storage), nullptr, handle);
+}
+
+// Decodes the whole source at the device rate and channel count
+static EST_RESULT sample_decode_shared(EST_AudioDevice *device, const EST_DecodeSource &source, EST_SharedPCM *pcm)
+{
+    std::vector<float> frames;
+    ma_uint32          channels = 0;
+    ma_uint32          sampleRate = 0;
+
+    ma_result result = DecodeParallel(source, 0, frames, &channels, &sampleRate);
+    if (result == MA_OUT_OF_MEMORY) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (result != MA_SUCCESS || channels == 0 || frames.empty()) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    ma_uint64 frameCount = frames.size() / channels;
+    ma_uint32 deviceRate = device->device.sampleRate;
+    ma_uint32 deviceChannels = static_cast<ma_uint32>(device->channels);
+
+    // Match the device layout so the mixer and the cache never convert again
+    if (sampleRate != deviceRate || channels != deviceChannels) {
+        ma_uint64 convertedCount = ma_convert_frames(nullptr, 0, ma_format_f32, deviceChannels, deviceRate, nullptr, frameCount, ma_format_f32, channels, sampleRate);
+
+        try {
+            pcm->frames.resize(convertedCount * deviceChannels);
+        } catch (const std::bad_alloc &) {
+            EST_SetError("Out of memory!");
+            return EST_ERROR_OUT_OF_MEMORY;
+        }
+
+        frameCount = ma_convert_frames(pcm->frames.data(), convertedCount, ma_format_f32, deviceChannels, deviceRate, frames.data(), frameCount, ma_format_f32, channels, sampleRate);
+        sampleRate = deviceRate;
+        channels = deviceChannels;
+    } else {
+        pcm->frames = std::move(frames);
+    }
+
+    if (frameCount == 0 || frameCount > static_cast<ma_uint64>(INT32_MAX)) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    pcm->frameCount = frameCount;
+    pcm->channels = static_cast<int>(channels);
+    pcm->sampleRate = static_cast<int>(sampleRate);
+
+    return EST_OK;
+}
+
+// Narrows frames to where the sound is, a sound that is silent throughout is kept whole
+static void sample_trim_silence(const float **frames, ma_uint64 *frameCount, int channels, float thresholdDb, EST_SoundAnalysis *analysis)
+{
+    float     threshold = std::pow(10.0f, thresholdDb / 20.0f);
+    ma_uint64 start = 0;
+    ma_uint64 end = 0;
+
+    FindSoundBounds(*frames, *frameCount, channels, threshold, &start, &end);
+    if (start >= end) {
+        return;
+    }
+
+    analysis->trimmedStart = start;
+    analysis->trimmedEnd = *frameCount - end;
+
+    *frames += start * channels;
+    *frameCount = end - start;
+}
+
+// Measures the kept frames on the worker, once however many handles share the sound.
+// owner keeps frames (or packed) alive until the job is done
+static void sample_queue_analysis(EST_AudioDevice *device, const std::shared_ptr<EST_SoundAnalysis> &analysis, std::shared_ptr<const void> owner, const float *frames, enum EST_SAMPLE_STORAGE storage, const unsigned char *packed, ma_uint64 frameCount, int channels, int sampleRate)
+{
+    if (!analysis || analysis->isQueued.exchange(true)) {
+        return;
+    }
+
+    WorkerPost(&device->worker, [analysis, owner, frames, storage, packed, frameCount, channels, sampleRate] {
+        std::vector<float> unpacked;
+        const float       *data = frames;
+
+        if (storage != EST_STORAGE_F32) {
+            EST_RawAudio raw;
+            raw.storage = storage;
+            raw.packed = packed;
+            raw.channels = channels;
+            raw.PCMSize = static_cast<int>(frameCount);
+
+            try {
+                unpacked.resize(static_cast<size_t>(frameCount * channels));
+                if (storage == EST_STORAGE_ADPCM) {
+                    raw.block.resize(kAdpcmBlockFrames * channels);
+                }
+            } catch (const std::bad_alloc &) {
+                // Left unready, the sound itself plays fine
+                return;
+            }
+
+            SamplePackedRead(&raw, unpacked.data(), frameCount);
+            data = unpacked.data();
+        }
+
+        AnalyzeFrames(data, frameCount, channels, sampleRate, &analysis->stats);
+        analysis->isReady.store(true, std::memory_order_release);
+    });
+}
+
+static void sample_queue_analysis(EST_AudioDevice *device, const std::shared_ptr<const EST_SharedPCM> &pcm)
+{
+    sample_queue_analysis(device, pcm->analysis, pcm, pcm->frames.data(), pcm->storage, pcm->packed.data(), pcm->frameCount, pcm->channels, pcm->sampleRate);
+}
+
+// Decodes the whole source up front and plays it from RAM at the device rate
+static EST_RESULT sample_load_decoded(EST_AudioDevice *device, const EST_DecodeSource &source, const est_decode_options &options, EST_AUDIO_HANDLE *handle)
+{
+    std::shared_ptr<const EST_SharedPCM> pooled;
+    std::shared_ptr<EST_SharedPCM>       pcm;
+    std::string                          key;
+
+    enum EST_SAMPLE_STORAGE storage = options.storage;
+    bool                    isTrimmed = (options.flags & EST_DECODE_TRIM_SILENCE) != 0;
+    bool                    isAnalyzed = (options.flags & EST_DECODE_ANALYZE) != 0;
+
+    try {
+        key = source.path
+                  ? SamplePoolFileKey(device, source.path)
+                  : SamplePoolDataKey(device, "data", source.data, source.size);
+
+        if (!key.empty() && storage != EST_STORAGE_F32) {
+            key += ":storage" + std::to_string(static_cast<int>(storage));
+        }
+
+        if (!key.empty() && isTrimmed) {
+            key += ":trim" + std::to_string(options.silenceThreshold);
+        }
+
+        pooled = SamplePoolFind(device, key);
+        if (!pooled) {
+            pcm = std::make_shared<EST_SharedPCM>();
+            pcm->analysis = std::make_shared<EST_SoundAnalysis>();
+        }
+    } catch (const std::bad_alloc &) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (pooled) {
+        if (isAnalyzed) {
+            sample_queue_analysis(device, pooled);
+        }
+
+        return sample_load_shared(device, pooled, handle);
+    }
+
+    // The disk cache maps its frames, already shared between handles through the mapping
+    EST_MappedPCM cached;
+    bool          isCached = source.path && SampleCacheLookup(device, source.path, &cached);
+
+    if (isCached && storage == EST_STORAGE_F32) {
+        cached.analysis = pcm->analysis;
+
+        // Trimming only narrows the view into the mapping
+        if (isTrimmed) {
+            sample_trim_silence(&cached.frames, &cached.frameCount, cached.channels, options.silenceThreshold, cached.analysis.get());
+        }
+
+        if (isAnalyzed) {
+            sample_queue_analysis(device, cached.analysis, cached.file, cached.frames, EST_STORAGE_F32, nullptr, cached.frameCount, cached.channels, cached.sampleRate);
+        }
+
+        return SampleLoadMappedPCM(device, cached, handle);
+    }
+
+    const float *frames = cached.frames;
+
+    if (isCached) {
+        pcm->frameCount = cached.frameCount;
+        pcm->channels = cached.channels;
+        pcm->sampleRate = cached.sampleRate;
+    } else {
+        EST_RESULT result = sample_decode_shared(device, source, pcm.get());
+        if (result != EST_OK) {
+            return result;
+        }
+
+        // The cache keeps every frame, trimming is redone from it on later loads
+        if (source.path) {
+            SampleCacheStore(device, source.path, pcm->frames.data(), pcm->frameCount, pcm->channels, pcm->sampleRate);
+        }
+
+        frames = pcm->frames.data();
+    }
+
+    if (isTrimmed) {
+        sample_trim_silence(&frames, &pcm->frameCount, pcm->channels, options.silenceThreshold, pcm->analysis.get());
+    }
+
+    try {
+        if (storage != EST_STORAGE_F32) {
+            PackFrames(storage, frames, pcm->frameCount, pcm->channels, pcm->packed);
+
+            pcm->storage = storage;
+            pcm->frames = std::vector<float>();
+        } else if (frames != pcm->frames.data() || pcm->frameCount * pcm->channels != pcm->frames.size()) {
+            pcm->frames = std::vector<float>(frames, frames + pcm->frameCount * pcm->channels);
+        }
+    } catch (const std::bad_alloc &) {
+        EST_SetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    pooled = SamplePoolInsert(device, key, std::move(pcm));
+    if (isAnalyzed) {
+        sample_queue_analysis(device, pooled);
+    }
+
+    return sample_load_shared(device, pooled, handle);
+}
+
+// Validated here so every decoded entry point reports the same errors
+static bool sample_check_options(const est_decode_options *options)
+{
+    if (!options) {
+        EST_SetError("'options' is nullptr");
+        return false;
+    }
+
+    if (options->storage < EST_STORAGE_F32 || options->storage > EST_STORAGE_ADPCM) {
+        EST_SetError("Invalid storage");
+        return false;
+    }
+
+    if ((options->flags & EST_DECODE_TRIM_SILENCE) && !(options->silenceThreshold <= 0.0f)) {
+        EST_SetError("Invalid silence threshold");
+        return false;
+    }
+
+    return true;
+}
+
+EST_RESULT EST_SampleLoadDecoded(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle)
+{
+    return EST_SampleLoadDecodedWithStorage(devhandle, path, format, EST_STORAGE_F32, handle);
+}
+
+EST_RESULT EST_SampleLoadDecodedWithStorage(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_AUDIO_FORMAT format, enum EST_SAMPLE_STORAGE storage, EST_AUDIO_HANDLE *handle)
+{
+    est_decode_options options = {};
+    options.storage = storage;
+
+    return EST_SampleLoadDecodedEx(devhandle, path, format, &options, handle);
+}
+
+EST_RESULT EST_SampleLoadDecodedEx(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_AUDIO_FORMAT format, const est_decode_options *options, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!path) {
+        EST_SetError("'path' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!sample_check_options(options)) {
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_DecodeSource source;
+    source.path = path;
+    source.format = format;
+
+    return sample_load_decoded(device, source, *options, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryDecoded(EST_DEVICE_HANDLE devhandle, const void *data, int size, enum EST_AUDIO_FORMAT format, EST_AUDIO_HANDLE *handle)
+{
+    return EST_SampleLoadMemoryDecodedWithStorage(devhandle, data, size, format, EST_STORAGE_F32, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryDecodedWithStorage(EST_DEVICE_HANDLE devhandle, const void *data, int size, enum EST_AUDIO_FORMAT format, enum EST_SAMPLE_STORAGE storage, EST_AUDIO_HANDLE *handle)
+{
+    est_decode_options options = {};
+    options.storage = storage;
+
+    return EST_SampleLoadMemoryDecodedEx(devhandle, data, size, format, &options, handle);
+}
+
+EST_RESULT EST_SampleLoadMemoryDecodedEx(EST_DEVICE_HANDLE devhandle, const void *data, int size, enum EST_AUDIO_FORMAT format, const est_decode_options *options, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!data || size <= 0) {
+        EST_SetError("'data' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!sample_check_options(options)) {
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_DecodeSource source;
+    source.data = data;
+    source.size = static_cast<size_t>(size);
+    source.format = format;
+
+    return sample_load_decoded(device, source, *options, handle);
+}
+
 EST_RESULT EST_SampleFree(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle)
 {
     auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
@@ -202,7 +819,19 @@ EST_RESULT EST_SampleFree(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle)
         return EST_ERROR;
     }
 
-    it->isRemoved = true;
+    // Queued samples hold references, drop them so playlists can't keep each other alive
+    {
+        std::lock_guard<std::mutex> lock(it->queueLock);
+        it->queue.clear();
+        it->retired.clear();
+    }
+
+    // Once the mixer is out of the source it never reads it again, borrowed buffers are free after this
+    {
+        std::lock_guard<std::mutex> lock(it->sourceLock);
+        SampleSettleSeek(it.get());
+        it->isRemoved = true;
+    }
 
     return EST_OK;
 }
\ No newline at end of file
@@ -5,4 +5,57 @@
 
 std::shared_ptr<EST_AudioSample> GetSample(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle);
 
+// Sets up the processing chain of a loaded sample and registers its handle
+EST_RESULT InternalInit(EST_DEVICE_HANDLE devhandle, std::shared_ptr<EST_AudioSample> sample, ma_format format, int channels, int sampleRate, EST_AUDIO_HANDLE *handle);
+
+// Source access, the caller must hold sample->sourceLock
+ma_uint64 SampleReadSource(EST_AudioSample *sample, float *pOutput, ma_uint64 frameCount);
+void      SampleSeekSource(EST_AudioSample *sample, ma_uint64 frameIndex);
+ma_uint64 SamplePackedRead(EST_RawAudio *raw, float *pOutput, ma_uint64 frameCount); // Unpacks compact storage to f32
+void      SampleSettleSeek(EST_AudioSample *sample); // Finishes a seek posted to the worker
+void      SampleRunSeek(EST_AudioSample *sample);    // Runs a posted seek unless another thread already took it, no lock needed
+ma_uint64 SampleGetLength(EST_AudioSample *sample);  // 0 when unknown, cached after the first call
+
+// Mixer read, wraps through the loop region while looping is enabled
+// Returns the frames read, isAtEnd is set once the source is exhausted
+ma_uint64 SampleReadFrames(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, float *pOutput, ma_uint64 frameCount, bool *isAtEnd);
+
+// Maps the file read-only, or returns the live mapping of the same file
+std::shared_ptr<EST_MappedFile> SampleMapFile(EST_AudioDevice *device, const char *path, int flags);
+
+// Indexes the pages of an Ogg source so decoder seeks skip the bisection search
+// From data right away when given, otherwise from path on the device worker
+void SampleBuildSeekIndex(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, const char *path, const void *data, size_t size);
+
+// Interleaved f32 frames inside a file mapping, from the cache directory or a sound bank
+struct EST_MappedPCM
+{
+    std::shared_ptr<EST_MappedFile> file;
+    const float                    *frames = nullptr;
+    ma_uint64                       frameCount = 0;
+    int                             channels = 0;
+    int                             sampleRate = 0;
+
+    std::shared_ptr<EST_SoundAnalysis> analysis; // Attached to the loaded sample
+};
+
+// Misses when caching is disabled or the entry is stale
+bool SampleCacheLookup(EST_AudioDevice *device, const char *path, EST_MappedPCM *cached);
+void SampleCacheStore(EST_AudioDevice *device, const char *path, const float *frames, ma_uint64 frameCount, int channels, int sampleRate);
+
+// Plays the frames straight from the mapped pages
+EST_RESULT SampleLoadMappedPCM(EST_AudioDevice *device, const EST_MappedPCM &pcm, EST_AUDIO_HANDLE *handle);
+
+// Pool keys, empty while the pool is disabled so nothing is hashed for nothing
+std::string SamplePoolFileKey(EST_AudioDevice *device, const char *path);
+std::string SamplePoolDataKey(EST_AudioDevice *device, const char *tag, const void *data, size_t size);
+
+// Finds a pooled sound and marks it recently used, counts a hit or a miss
+std::shared_ptr<const EST_SharedPCM> SamplePoolFind(EST_AudioDevice *device, const std::string &key);
+
+// Pools the sound and evicts past the budget, returns the entry another load pooled first if any
+std::shared_ptr<const EST_SharedPCM> SamplePoolInsert(EST_AudioDevice *device, const std::string &key, std::shared_ptr<const EST_SharedPCM> pcm);
+
+EST_RESULT SampleBuildLoopRegion(EST_AudioSample *sample, ma_uint64 start, ma_uint64 end, ma_uint64 crossfade);
+
 #endif
\ No newline at end of file
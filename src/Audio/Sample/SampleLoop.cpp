@@ -0,0 +1,606 @@
+#include "SampleInternal.h"
+#include <cmath>
+
+namespace {
+    constexpr int   kLoopHeadMilliseconds = 500;
+    constexpr float kHalfPi = 1.57079632679f;
+} // namespace
+
+ma_uint64 SampleReadSource(EST_AudioSample *sample, float *pOutput, ma_uint64 frameCount)
+{
+    ma_uint64 framesRead = 0;
+
+    if (sample->rawAudio && sample->rawAudio->packed) {
+        framesRead = SamplePackedRead(sample->rawAudio.get(), pOutput, frameCount);
+    } else if (sample->rawAudio) {
+        framesRead = ma_audio_buffer_read_pcm_frames(&sample->rawAudio->decoder, pOutput, frameCount, MA_FALSE);
+    } else {
+        // MA_AT_END is reported through framesRead as well
+        ma_decoder_read_pcm_frames(&sample->decoder, pOutput, frameCount, &framesRead);
+    }
+
+    sample->cursor += framesRead;
+    return framesRead;
+}
+
+ma_uint64 SamplePackedRead(EST_RawAudio *raw, float *pOutput, ma_uint64 frameCount)
+{
+    int       channels = raw->channels;
+    ma_uint64 framesRead = std::min(frameCount, static_cast<ma_uint64>(raw->PCMSize) - raw->cursor);
+
+    switch (raw->storage) {
+        case EST_STORAGE_S16:
+            UnpackS16(raw->packed + raw->cursor * channels * 2, pOutput, static_cast<size_t>(framesRead * channels));
+            break;
+        case EST_STORAGE_F16:
+            UnpackF16(raw->packed + raw->cursor * channels * 2, pOutput, static_cast<size_t>(framesRead * channels));
+            break;
+        default:
+            // ADPCM, one block decoded at a time into memory allocated at load
+            for (ma_uint64 done = 0; done < framesRead;) {
+                ma_uint64 frame = raw->cursor + done;
+                ma_uint64 blockIndex = frame / kAdpcmBlockFrames;
+
+                if (blockIndex != raw->blockIndex) {
+                    AdpcmDecodeBlock(raw->packed + blockIndex * AdpcmBlockSize(channels), channels, raw->block.data());
+                    raw->blockIndex = blockIndex;
+                }
+
+                ma_uint64 offset = frame % kAdpcmBlockFrames;
+                ma_uint64 frames = std::min(framesRead - done, kAdpcmBlockFrames - offset);
+
+                std::copy_n(&raw->block[offset * channels], frames * channels, pOutput + done * channels);
+                done += frames;
+            }
+            break;
+    }
+
+    raw->cursor += framesRead;
+    return framesRead;
+}
+
+void SampleSeekSource(EST_AudioSample *sample, ma_uint64 frameIndex)
+{
+    SampleSettleSeek(sample);
+
+    if (sample->rawAudio && sample->rawAudio->packed) {
+        sample->rawAudio->cursor = std::min(frameIndex, static_cast<ma_uint64>(sample->rawAudio->PCMSize));
+    } else if (sample->rawAudio) {
+        ma_audio_buffer_seek_to_pcm_frame(&sample->rawAudio->decoder, frameIndex);
+    } else {
+        ma_decoder_seek_to_pcm_frame(&sample->decoder, frameIndex);
+    }
+
+    sample->cursor = frameIndex;
+    sample->stage = EST_ReadStage::Source;
+    sample->stagePosition = 0;
+}
+
+void SampleRunSeek(EST_AudioSample *sample)
+{
+    auto expected = EST_SeekState::Requested;
+    if (sample->seekState.compare_exchange_strong(expected, EST_SeekState::Running)) {
+        ma_decoder_seek_to_pcm_frame(&sample->decoder, sample->seekTarget);
+        sample->seekState = EST_SeekState::Idle;
+    }
+}
+
+void SampleSettleSeek(EST_AudioSample *sample)
+{
+    SampleRunSeek(sample);
+
+    while (sample->seekState.load() == EST_SeekState::Running) {
+        std::this_thread::yield();
+    }
+}
+
+ma_uint64 SampleGetLength(EST_AudioSample *sample)
+{
+    if (sample->length > 0) {
+        return sample->length;
+    }
+
+    if (sample->rawAudio) {
+        sample->length = static_cast<ma_uint64>(sample->rawAudio->PCMSize);
+    } else {
+        // Some backends scan the whole stream here, never call it from the mixer
+        SampleSettleSeek(sample);
+
+        ma_uint64 length = 0;
+        if (ma_decoder_get_length_in_pcm_frames(&sample->decoder, &length) == MA_SUCCESS) {
+            sample->length = length;
+        }
+    }
+
+    return sample->length;
+}
+
+void SampleBuildSeekIndex(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, const char *path, const void *data, size_t size)
+{
+    if (sample->rawAudio || !DecoderIsOgg(&sample->decoder)) {
+        return;
+    }
+
+    if (data) {
+        // Only page headers are touched, cheap enough to do while loading
+        if (BuildOggSeekIndex(data, size, sample->seekIndex)) {
+            DecoderBindSeekIndex(&sample->decoder, sample->seekIndex);
+        }
+
+        return;
+    }
+
+    if (!path) {
+        return;
+    }
+
+    std::string source = path;
+
+    WorkerPost(&device->worker, [sample, source] {
+        std::vector<ma_ogg_seek_point> points;
+        if (!BuildOggSeekIndexFile(source.c_str(), points)) {
+            return;
+        }
+
+        // Decoder seeks only run under the source lock or on this worker
+        std::lock_guard<std::mutex> lock(sample->sourceLock);
+        sample->seekIndex = std::move(points);
+        DecoderBindSeekIndex(&sample->decoder, sample->seekIndex);
+    });
+}
+
+// Hands a decoder seek to the worker, the mixer must not touch the decoder until it settles
+static void sample_request_seek(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, ma_uint64 frameIndex)
+{
+    sample->seekTarget = frameIndex;
+    sample->seekState = EST_SeekState::Requested;
+    sample->isSeekPosted = WorkerPostSeek(&device->worker, sample);
+}
+
+// True while the worker still has to move the decoder, posts again if every slot was taken before
+static bool sample_seek_pending(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample)
+{
+    if (sample->seekState.load() == EST_SeekState::Idle) {
+        return false;
+    }
+
+    if (!sample->isSeekPosted) {
+        sample->isSeekPosted = WorkerPostSeek(&device->worker, sample);
+    }
+
+    return true;
+}
+
+// Moves a decoder to frameIndex from the mixer, reading nothing until the worker is done
+static void sample_seek_async(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, ma_uint64 frameIndex)
+{
+    if (sample->rawAudio) {
+        // Raw buffers seek for free
+        SampleSeekSource(sample.get(), frameIndex);
+        return;
+    }
+
+    sample->cursor = frameIndex;
+    sample->stage = EST_ReadStage::Seek;
+    sample->stagePosition = 0;
+
+    sample_request_seek(device, sample, frameIndex);
+}
+
+static void sample_wrap_loop(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample)
+{
+    EST_LoopRegion *loop = sample->loop.get();
+    ma_uint64       start = loop ? loop->start : 0;
+
+    if (!loop || (loop->headFrames == 0 && !loop->isResident)) {
+        sample_seek_async(device, sample, start);
+        return;
+    }
+
+    sample->cursor = start;
+    sample->stage = EST_ReadStage::Head;
+    sample->stagePosition = 0;
+
+    // Play the cached head while the worker moves the decoder past it, a resident loop never needs the decoder
+    if (!loop->isResident) {
+        sample_request_seek(device, sample, start + loop->headFrames);
+    }
+}
+
+ma_uint64 SampleReadFrames(EST_AudioDevice *device, const std::shared_ptr<EST_AudioSample> &sample, float *pOutput, ma_uint64 frameCount, bool *isAtEnd)
+{
+    *isAtEnd = false;
+
+    // The source is being repositioned by another thread, skip this block
+    std::unique_lock<std::mutex> lock(sample->sourceLock, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0;
+    }
+
+    // Freed, the memory behind the source may already be gone
+    if (sample->isRemoved) {
+        *isAtEnd = true;
+        return 0;
+    }
+
+    int             channels = sample->channels;
+    bool            looping = sample->attributes.looping;
+    EST_LoopRegion *loop = sample->loop.get();
+    ma_uint64       totalFramesRead = 0;
+    int             emptyWraps = 0;
+
+    while (totalFramesRead < frameCount) {
+        float    *pDst = pOutput + totalFramesRead * channels;
+        ma_uint64 framesRemaining = frameCount - totalFramesRead;
+
+        if (sample->stage == EST_ReadStage::Head) {
+            ma_uint64 framesToCopy = std::min(framesRemaining, loop->headFrames - sample->stagePosition);
+            std::copy_n(&loop->head[sample->stagePosition * channels], framesToCopy * channels, pDst);
+
+            sample->stagePosition += framesToCopy;
+            sample->cursor += framesToCopy;
+            totalFramesRead += framesToCopy;
+
+            if (sample->stagePosition == loop->headFrames) {
+                if (!loop->isResident) {
+                    sample->stage = EST_ReadStage::Seek;
+                } else if (looping) {
+                    sample->stage = EST_ReadStage::Tail;
+                    sample->stagePosition = 0;
+                } else {
+                    // Looping was turned off, the decoder still sits wherever it last stopped
+                    sample_seek_async(device, sample, sample->cursor);
+                }
+            }
+
+            continue;
+        }
+
+        if (sample->stage == EST_ReadStage::Seek) {
+            // Never wait on the worker here, the rest of the block stays silent
+            if (sample_seek_pending(device, sample)) {
+                break;
+            }
+
+            sample->stage = EST_ReadStage::Source;
+            continue;
+        }
+
+        if (sample->stage == EST_ReadStage::Prime) {
+            ma_uint64 framesToCopy = std::min(framesRemaining, sample->primeFrames - sample->stagePosition);
+            std::copy_n(&sample->prime[sample->stagePosition * channels], framesToCopy * channels, pDst);
+
+            sample->stagePosition += framesToCopy;
+            sample->cursor += framesToCopy;
+            totalFramesRead += framesToCopy;
+
+            // The decoder already sits right after the primed frames
+            if (sample->stagePosition == sample->primeFrames) {
+                sample->stage = EST_ReadStage::Source;
+            }
+
+            continue;
+        }
+
+        if (sample->stage == EST_ReadStage::Tail) {
+            ma_uint64 framesToCopy = std::min(framesRemaining, loop->tailFrames - sample->stagePosition);
+            std::copy_n(&loop->tail[sample->stagePosition * channels], framesToCopy * channels, pDst);
+
+            sample->stagePosition += framesToCopy;
+            sample->cursor += framesToCopy;
+            totalFramesRead += framesToCopy;
+
+            if (sample->stagePosition == loop->tailFrames) {
+                if (looping) {
+                    sample_wrap_loop(device, sample);
+                } else {
+                    // Looping was turned off during the crossfade, continue after the region
+                    sample_seek_async(device, sample, sample->cursor);
+                }
+            }
+
+            continue;
+        }
+
+        ma_uint64 framesToRead = framesRemaining;
+        if (looping && loop && loop->end > 0) {
+            ma_uint64 fadeStart = loop->end - loop->tailFrames;
+
+            if (sample->cursor >= loop->end) {
+                sample_wrap_loop(device, sample);
+                continue;
+            }
+
+            if (sample->cursor >= fadeStart) {
+                sample->stage = EST_ReadStage::Tail;
+                sample->stagePosition = sample->cursor - fadeStart;
+                continue;
+            }
+
+            framesToRead = std::min(framesToRead, fadeStart - sample->cursor);
+        }
+
+        // The read-ahead thread is still refilling, decoding now would wait on the source
+        if (sample->stream && !StreamIsReady(sample->stream)) {
+            break;
+        }
+
+        ma_uint64 framesRead = SampleReadSource(sample.get(), pDst, framesToRead);
+        totalFramesRead += framesRead;
+
+        if (framesRead < framesToRead) {
+            // Stream ended before the loop end, or the region produced nothing at all
+            if (!looping || (framesRead == 0 && ++emptyWraps > 1)) {
+                *isAtEnd = true;
+                break;
+            }
+
+            sample_wrap_loop(device, sample);
+        } else {
+            emptyWraps = 0;
+        }
+    }
+
+    return totalFramesRead;
+}
+
+namespace {
+    // Reads loop frames without moving the playing source. Raw frames never change and are read in place,
+    // decoded sources get a decoder of their own. Only callback streams read the playing decoder, under the lock.
+    struct EST_LoopReader
+    {
+        EST_AudioSample *sample = nullptr;
+        EST_RawAudio     view; // Own cursor and ADPCM block over the packed frames
+        ma_decoder       decoder = {};
+        bool             isDecoder = false;
+        bool             isShared = false;
+
+        ~EST_LoopReader()
+        {
+            if (isDecoder) {
+                ma_decoder_uninit(&decoder);
+            }
+        }
+    };
+} // namespace
+
+static EST_RESULT loop_reader_open(EST_AudioSample *sample, EST_LoopReader *reader)
+{
+    reader->sample = sample;
+
+    if (sample->rawAudio) {
+        EST_RawAudio *raw = sample->rawAudio.get();
+
+        reader->view.storage = raw->storage;
+        reader->view.packed = raw->packed;
+        reader->view.channels = raw->channels;
+        reader->view.PCMSize = raw->PCMSize;
+
+        try {
+            reader->view.block.resize(raw->block.size());
+        } catch (std::bad_alloc &alloc) {
+            EST_SetError(alloc.what());
+            return EST_ERROR_OUT_OF_MEMORY;
+        }
+
+        return EST_OK;
+    }
+
+    if (sample->sourcePath.empty() && !sample->sourceData) {
+        reader->isShared = true;
+        return EST_OK;
+    }
+
+    // Same output as the playing decoder, its MP3 seek table never changes after init and is borrowed
+    ma_decoder_config config = ma_decoder_config_init(sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate);
+    config.seekPointCount = kDecoderSharedSeekTable;
+
+    ma_result result = !sample->sourcePath.empty()
+                           ? DecoderInitFile(sample->sourcePath.c_str(), &config, sample->sourceFormat, &reader->decoder)
+                           : DecoderInitMemory(sample->sourceData, sample->sourceSize, nullptr, &config, sample->sourceFormat, &reader->decoder);
+
+    if (result != MA_SUCCESS) {
+        EST_SetError("Failed to open the loop source");
+        return EST_ERROR;
+    }
+
+    reader->isDecoder = true;
+    DecoderShareSeekTable(&sample->decoder, &reader->decoder);
+
+    return EST_OK;
+}
+
+static ma_uint64 loop_reader_length(EST_LoopReader *reader)
+{
+    if (reader->sample->rawAudio) {
+        return static_cast<ma_uint64>(reader->sample->rawAudio->PCMSize);
+    }
+
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&reader->decoder, &length);
+    return length;
+}
+
+static ma_uint64 loop_reader_read(EST_LoopReader *reader, ma_uint64 frameIndex, float *pOutput, ma_uint64 frameCount)
+{
+    EST_AudioSample *sample = reader->sample;
+
+    if (reader->isShared) {
+        SampleSeekSource(sample, frameIndex);
+        return SampleReadSource(sample, pOutput, frameCount);
+    }
+
+    if (reader->isDecoder) {
+        ma_uint64 framesRead = 0;
+        if (ma_decoder_seek_to_pcm_frame(&reader->decoder, frameIndex) == MA_SUCCESS) {
+            ma_decoder_read_pcm_frames(&reader->decoder, pOutput, frameCount, &framesRead);
+        }
+
+        return framesRead;
+    }
+
+    EST_RawAudio *raw = sample->rawAudio.get();
+    ma_uint64     size = static_cast<ma_uint64>(raw->PCMSize);
+    if (frameIndex >= size) {
+        return 0;
+    }
+
+    if (raw->packed) {
+        reader->view.cursor = frameIndex;
+        return SamplePackedRead(&reader->view, pOutput, frameCount);
+    }
+
+    ma_uint64    framesRead = std::min(frameCount, size - frameIndex);
+    const float *pFrames = static_cast<const float *>(raw->decoder.ref.pData);
+
+    std::copy_n(pFrames + frameIndex * sample->channels, framesRead * sample->channels, pOutput);
+    return framesRead;
+}
+
+static EST_RESULT loop_build(EST_LoopReader *reader, ma_uint64 start, ma_uint64 end, ma_uint64 crossfade, ma_uint64 length, std::unique_ptr<EST_LoopRegion> &loop)
+{
+    EST_AudioSample *sample = reader->sample;
+
+    if (end == 0 || (length > 0 && end > length)) {
+        end = length;
+    }
+
+    if ((end > 0 && start >= end) || (length > 0 && start >= length)) {
+        EST_SetError("Invalid loop region");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Crossfading mixes the frames before start into the end of the loop
+    ma_uint64 fadeFrames = end > 0 ? std::min({ crossfade, start, end - start }) : 0;
+    ma_uint64 headFrames = 0;
+
+    // The head stops where the tail begins, or the tail would never be played
+    if (!sample->rawAudio) {
+        headFrames = static_cast<ma_uint64>(sample->sampleRate) * kLoopHeadMilliseconds / 1000;
+        if (end > 0) {
+            headFrames = std::min(headFrames, end - start - fadeFrames);
+        }
+    }
+
+    int                channels = sample->channels;
+    std::vector<float> lead;
+
+    try {
+        loop = std::make_unique<EST_LoopRegion>();
+        loop->tail.resize(fadeFrames * channels);
+        lead.resize((fadeFrames + headFrames) * channels);
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    ma_uint64 leadFrames = loop_reader_read(reader, start - fadeFrames, lead.data(), fadeFrames + headFrames);
+    if (leadFrames < fadeFrames) {
+        fadeFrames = 0;
+        headFrames = 0;
+    } else {
+        headFrames = leadFrames - fadeFrames;
+    }
+
+    loop->start = start;
+    loop->end = end;
+    loop->headFrames = headFrames;
+    loop->isResident = !sample->rawAudio && end > 0 && start + headFrames + fadeFrames == end;
+    loop->head.assign(lead.begin() + fadeFrames * channels, lead.begin() + (fadeFrames + headFrames) * channels);
+
+    if (fadeFrames > 0) {
+        loop_reader_read(reader, end - fadeFrames, loop->tail.data(), fadeFrames);
+
+        // Equal power, the lead-in frames continue seamlessly into start
+        for (ma_uint64 i = 0; i < fadeFrames; i++) {
+            float t = (static_cast<float>(i) + 0.5f) / static_cast<float>(fadeFrames);
+            float gainOut = std::cos(t * kHalfPi);
+            float gainIn = std::sin(t * kHalfPi);
+
+            for (int c = 0; c < channels; c++) {
+                float &out = loop->tail[i * channels + c];
+                out = out * gainOut + lead[i * channels + c] * gainIn;
+            }
+        }
+    }
+
+    loop->tailFrames = fadeFrames;
+    loop->tail.resize(fadeFrames * channels);
+
+    return EST_OK;
+}
+
+EST_RESULT SampleBuildLoopRegion(EST_AudioSample *sample, ma_uint64 start, ma_uint64 end, ma_uint64 crossfade)
+{
+    EST_LoopReader reader;
+
+    EST_RESULT result = loop_reader_open(sample, &reader);
+    if (result != EST_OK) {
+        return result;
+    }
+
+    std::unique_ptr<EST_LoopRegion> loop;
+
+    if (reader.isShared) {
+        std::lock_guard<std::mutex> lock(sample->sourceLock);
+
+        ma_uint64 restoreCursor = sample->cursor;
+        result = loop_build(&reader, start, end, crossfade, SampleGetLength(sample), loop);
+
+        if (result == EST_OK) {
+            SampleSeekSource(sample, restoreCursor);
+            sample->loop = std::move(loop);
+        }
+
+        return result;
+    }
+
+    // Nothing the mixer reads is touched until the finished region is swapped in
+    ma_uint64 length = loop_reader_length(&reader);
+    result = loop_build(&reader, start, end, crossfade, length, loop);
+    if (result != EST_OK) {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(sample->sourceLock);
+
+    if (sample->length == 0) {
+        sample->length = length;
+    }
+
+    // Head and tail positions belong to the old region, pick up from the same frame without it
+    if (sample->stage == EST_ReadStage::Head || sample->stage == EST_ReadStage::Tail) {
+        SampleSeekSource(sample, sample->cursor);
+    }
+
+    sample->loop = std::move(loop);
+
+    return EST_OK;
+}
+
+EST_RESULT EST_SampleSetLoopRegion(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle, int loopStart, int loopEnd, int crossfade)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    auto it = GetSample(device, handle);
+    if (!it) {
+        EST_SetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (loopStart < 0 || loopEnd < 0 || crossfade < 0) {
+        EST_SetError("Invalid loop region");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    return SampleBuildLoopRegion(
+        it.get(),
+        static_cast<ma_uint64>(loopStart),
+        static_cast<ma_uint64>(loopEnd),
+        static_cast<ma_uint64>(crossfade));
+}
\ No newline at end of file
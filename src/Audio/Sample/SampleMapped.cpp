@@ -0,0 +1,290 @@
+#include "SampleInternal.h"
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    constexpr int kWaveFormatFloat = 3;
+    constexpr int kWaveFormatExtensible = 0xFFFE;
+
+    struct EST_WaveInfo
+    {
+        int    format = 0;
+        int    channels = 0;
+        int    sampleRate = 0;
+        int    bitsPerSample = 0;
+        size_t dataOffset = 0;
+        size_t dataSize = 0;
+    };
+} // namespace
+
+std::shared_ptr<EST_MappedFile> SampleMapFile(EST_AudioDevice *device, const char *path, int flags)
+{
+    std::error_code error;
+    std::string     key = std::filesystem::weakly_canonical(path, error).string();
+    if (error) {
+        key = path;
+    }
+
+    // A file rewritten in place of the mapped one (like a refreshed .estpcm) must not hit the old pages
+    uintmax_t size = std::filesystem::file_size(path, error);
+    int64_t   time = error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    bool      isStamped = !error;
+
+    std::lock_guard<std::mutex> lock(device->mappingLock);
+
+    auto it = device->mappings.find(key);
+    if (isStamped && it != device->mappings.end() && it->second.size == size && it->second.time == time) {
+        if (auto file = it->second.file.lock()) {
+            MapAdvise(file.get(), flags);
+            return file;
+        }
+    }
+
+    const char *mapError = nullptr;
+
+    auto file = MapFile(path, flags, &mapError);
+    if (!file) {
+        EST_SetError(mapError);
+        return nullptr;
+    }
+
+    for (auto entry = device->mappings.begin(); entry != device->mappings.end();) {
+        if (entry->second.file.expired()) {
+            entry = device->mappings.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+
+    // Older mappings stay alive for the handles that hold them, only new loads see this one
+    if (isStamped) {
+        device->mappings[key] = { file, size, time };
+    } else {
+        device->mappings.erase(key);
+    }
+
+    return file;
+}
+
+static uint32_t read_u32(const unsigned char *data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static uint16_t read_u16(const unsigned char *data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static bool parse_wave(const EST_MappedFile *file, EST_WaveInfo *info)
+{
+    const unsigned char *data = file->data;
+    size_t               size = file->size;
+
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool   hasFormat = false;
+    size_t offset = 12;
+
+    while (offset + 8 <= size) {
+        const unsigned char *chunk = data + offset;
+        size_t               chunkSize = read_u32(chunk + 4);
+        size_t               body = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && body + chunkSize <= size) {
+            info->format = read_u16(data + body);
+            info->channels = read_u16(data + body + 2);
+            info->sampleRate = static_cast<int>(read_u32(data + body + 4));
+            info->bitsPerSample = read_u16(data + body + 14);
+
+            // The sub format GUID starts with the real format tag
+            if (info->format == kWaveFormatExtensible && chunkSize >= 40) {
+                info->format = read_u16(data + body + 24);
+            }
+
+            hasFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            info->dataOffset = body;
+            info->dataSize = std::min(chunkSize, size - body);
+            return hasFormat;
+        }
+
+        // Chunks are padded to an even size
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+EST_RESULT EST_SampleLoadMapped(EST_DEVICE_HANDLE devhandle, const char *path, enum EST_MAP_FLAGS flags, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!path) {
+        EST_SetError("'path' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto file = SampleMapFile(device, path, flags);
+    if (!file) {
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<EST_AudioSample> sample;
+    std::shared_ptr<EST_RawAudio>    rawAudio;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+        rawAudio = std::make_shared<EST_RawAudio>();
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    sample->storage = file;
+
+    // Float WAV at the device rate is what the mixer reads, play it straight from the mapped pages
+    EST_WaveInfo wave;
+    if (parse_wave(file.get(), &wave) &&
+        wave.format == kWaveFormatFloat &&
+        wave.bitsPerSample == 32 &&
+        wave.channels > 0 &&
+        wave.sampleRate == static_cast<int>(device->device.sampleRate) &&
+        wave.dataOffset % sizeof(float) == 0) {
+
+        ma_uint64 frames = wave.dataSize / (sizeof(float) * wave.channels);
+        if (frames == 0 || frames > static_cast<ma_uint64>(INT32_MAX)) {
+            EST_SetError("Failed to map audio file");
+            return EST_ERROR_INVALID_ARGUMENT;
+        }
+
+        ma_audio_buffer_config config = ma_audio_buffer_config_init(
+            ma_format_f32,
+            wave.channels,
+            frames,
+            file->data + wave.dataOffset,
+            nullptr);
+
+        if (ma_audio_buffer_init(&config, &rawAudio->decoder) != MA_SUCCESS) {
+            EST_SetError("Failed to map audio file");
+            return EST_ERROR_INVALID_ARGUMENT;
+        }
+
+        rawAudio->PCMSize = static_cast<int>(frames);
+        sample->rawAudio = rawAudio;
+
+        return InternalInit(device, sample, ma_format_f32, wave.channels, wave.sampleRate, handle);
+    }
+
+    // Anything else decodes from the mapped pages instead of stdio reads
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, device->device.sampleRate);
+
+    if (DecoderInitMemory(file->data, file->size, path, &config, EST_FORMAT_AUTO, &sample->decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    SampleBuildSeekIndex(device, sample, nullptr, file->data, file->size);
+
+    return InternalInit(device, sample, sample->decoder.outputFormat, sample->decoder.outputChannels, sample->decoder.outputSampleRate, handle);
+}
+
+EST_RESULT EST_SampleLoadRawPCMMapped(EST_DEVICE_HANDLE devhandle, const char *path, int channels, int sampleRate, enum EST_MAP_FLAGS flags, EST_AUDIO_HANDLE *handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!path || channels <= 0 || sampleRate <= 0) {
+        EST_SetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto file = SampleMapFile(device, path, flags);
+    if (!file) {
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<EST_AudioSample> sample;
+    std::shared_ptr<EST_RawAudio>    rawAudio;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+        rawAudio = std::make_shared<EST_RawAudio>();
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    ma_uint64 frames = file->size / (sizeof(float) * channels);
+    if (frames == 0 || frames > static_cast<ma_uint64>(INT32_MAX)) {
+        EST_SetError("Failed to map audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    ma_audio_buffer_config config = ma_audio_buffer_config_init(
+        ma_format_f32,
+        channels,
+        frames,
+        file->data,
+        nullptr);
+
+    if (ma_audio_buffer_init(&config, &rawAudio->decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to map audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    rawAudio->PCMSize = static_cast<int>(frames);
+    sample->rawAudio = rawAudio;
+    sample->storage = file;
+
+    return InternalInit(device, sample, ma_format_f32, channels, sampleRate, handle);
+}
+
+EST_RESULT SampleLoadMappedPCM(EST_AudioDevice *device, const EST_MappedPCM &pcm, EST_AUDIO_HANDLE *handle)
+{
+    if (pcm.frameCount > static_cast<ma_uint64>(INT32_MAX)) {
+        EST_SetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<EST_AudioSample> sample;
+    std::shared_ptr<EST_RawAudio>    rawAudio;
+
+    try {
+        sample = std::shared_ptr<EST_AudioSample>(new EST_AudioSample, EST_AudioDestructor{});
+        rawAudio = std::make_shared<EST_RawAudio>();
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    ma_audio_buffer_config config = ma_audio_buffer_config_init(
+        ma_format_f32,
+        pcm.channels,
+        pcm.frameCount,
+        pcm.frames,
+        nullptr);
+
+    if (ma_audio_buffer_init(&config, &rawAudio->decoder) != MA_SUCCESS) {
+        EST_SetError("Failed to map audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    rawAudio->PCMSize = static_cast<int>(pcm.frameCount);
+    sample->rawAudio = rawAudio;
+    sample->storage = pcm.file;
+    sample->analysis = pcm.analysis;
+
+    return InternalInit(device, sample, ma_format_f32, pcm.channels, pcm.sampleRate, handle);
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "SampleInternal.h"
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+    constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+    constexpr uint64_t kFnvPrime = 1099511628211ull;
+} // namespace
+
+static bool pool_is_enabled(EST_AudioDevice *device)
+{
+    std::lock_guard<std::mutex> lock(device->pool.lock);
+    return device->pool.isEnabled;
+}
+
+static size_t pool_size(const EST_SharedPCM &pcm)
+{
+    return pcm.frames.capacity() * sizeof(float) + pcm.packed.capacity();
+}
+
+// Only the pool holds these, whoever else had them let go and can't get them back without the lock
+static void pool_evict(EST_SamplePool *pool)
+{
+    for (auto it = pool->order.end(); it != pool->order.begin() && pool->bytes > pool->budget;) {
+        --it;
+
+        auto entry = pool->entries.find(*it);
+        if (entry->second.pcm.use_count() > 1) {
+            continue;
+        }
+
+        pool->bytes -= pool_size(*entry->second.pcm);
+        pool->evictions++;
+        pool->entries.erase(entry);
+        it = pool->order.erase(it);
+    }
+}
+
+std::string SamplePoolFileKey(EST_AudioDevice *device, const char *path)
+{
+    if (!pool_is_enabled(device)) {
+        return {};
+    }
+
+    // Size and modification time keep an edited file from hitting its old sound
+    std::error_code error;
+    std::string     key = std::filesystem::weakly_canonical(path, error).string();
+    if (error) {
+        return {};
+    }
+
+    auto size = std::filesystem::file_size(path, error);
+    if (error) {
+        return {};
+    }
+
+    auto time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    if (error) {
+        return {};
+    }
+
+    char stamp[64];
+    std::snprintf(stamp, sizeof(stamp), ":%llu:%lld", static_cast<unsigned long long>(size), static_cast<long long>(time));
+
+    return "file:" + key + stamp;
+}
+
+std::string SamplePoolDataKey(EST_AudioDevice *device, const char *tag, const void *data, size_t size)
+{
+    if (!pool_is_enabled(device)) {
+        return {};
+    }
+
+    auto     bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = kFnvOffset;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+
+    char key[64];
+    std::snprintf(key, sizeof(key), "%s:%016llx:%llu", tag, static_cast<unsigned long long>(hash), static_cast<unsigned long long>(size));
+
+    return key;
+}
+
+std::shared_ptr<const EST_SharedPCM> SamplePoolFind(EST_AudioDevice *device, const std::string &key)
+{
+    if (key.empty()) {
+        return nullptr;
+    }
+
+    EST_SamplePool             *pool = &device->pool;
+    std::lock_guard<std::mutex> lock(pool->lock);
+
+    if (!pool->isEnabled) {
+        return nullptr;
+    }
+
+    auto it = pool->entries.find(key);
+    if (it == pool->entries.end()) {
+        pool->misses++;
+        return nullptr;
+    }
+
+    pool->hits++;
+    pool->order.splice(pool->order.begin(), pool->order, it->second.order);
+
+    return it->second.pcm;
+}
+
+std::shared_ptr<const EST_SharedPCM> SamplePoolInsert(EST_AudioDevice *device, const std::string &key, std::shared_ptr<const EST_SharedPCM> pcm)
+{
+    if (key.empty()) {
+        return pcm;
+    }
+
+    EST_SamplePool             *pool = &device->pool;
+    std::lock_guard<std::mutex> lock(pool->lock);
+
+    if (!pool->isEnabled) {
+        return pcm;
+    }
+
+    // Loaded twice at once, keep the first so both handles share it
+    auto it = pool->entries.find(key);
+    if (it != pool->entries.end()) {
+        return it->second.pcm;
+    }
+
+    // Failing to pool only costs sharing, the load itself still works
+    try {
+        pool->order.push_front(key);
+    } catch (std::bad_alloc &) {
+        return pcm;
+    }
+
+    try {
+        pool->entries.emplace(key, EST_SamplePoolEntry{ pcm, pool->order.begin() });
+    } catch (std::bad_alloc &) {
+        pool->order.pop_front();
+        return pcm;
+    }
+
+    pool->bytes += pool_size(*pcm);
+    pool_evict(pool);
+
+    return pcm;
+}
+
+EST_RESULT EST_DeviceSetSampleCache(EST_DEVICE_HANDLE devhandle, enum EST_BOOL enabled, long long budget)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (budget < 0) {
+        EST_SetError("Invalid budget");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_SamplePool             *pool = &device->pool;
+    std::lock_guard<std::mutex> lock(pool->lock);
+
+    pool->isEnabled = enabled == EST_TRUE;
+    pool->budget = static_cast<size_t>(budget);
+
+    if (!pool->isEnabled) {
+        // Handles keep their sounds, only the pool lets go
+        pool->entries.clear();
+        pool->order.clear();
+        pool->bytes = 0;
+    }
+
+    pool_evict(pool);
+    return EST_OK;
+}
+
+EST_RESULT EST_DeviceGetSampleCacheStats(EST_DEVICE_HANDLE devhandle, est_sample_cache_stats *stats)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!stats) {
+        EST_SetError("'stats' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_SamplePool             *pool = &device->pool;
+    std::lock_guard<std::mutex> lock(pool->lock);
+
+    // Sounds only held by the pool are the ones that could be evicted right now
+    long long unusedBytes = 0;
+    for (const auto &entry : pool->entries) {
+        if (entry.second.pcm.use_count() == 1) {
+            unusedBytes += static_cast<long long>(pool_size(*entry.second.pcm));
+        }
+    }
+
+    stats->budget = static_cast<long long>(pool->budget);
+    stats->bytes = static_cast<long long>(pool->bytes);
+    stats->unusedBytes = unusedBytes;
+    stats->entries = static_cast<int>(pool->entries.size());
+    stats->hits = static_cast<long long>(pool->hits);
+    stats->misses = static_cast<long long>(pool->misses);
+    stats->evictions = static_cast<long long>(pool->evictions);
+
+    return EST_OK;
+}
\ No newline at end of file
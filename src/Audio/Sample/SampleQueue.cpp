@@ -0,0 +1,121 @@
+#include "SampleInternal.h"
+
+namespace {
+    constexpr int kQueuePrimeMilliseconds = 250;
+} // namespace
+
+// Decodes the first blocks of a queued sample so the handoff never waits on the decoder
+static void sample_prime(EST_AudioSample *sample)
+{
+    std::lock_guard<std::mutex> lock(sample->sourceLock);
+
+    // Freed while the job waited, the memory behind the source may already be gone
+    if (sample->isRemoved) {
+        return;
+    }
+
+    // Anything but a rewound idle sample means it was started in the meantime
+    if (sample->rawAudio || sample->isPlaying || sample->cursor != 0 || sample->stage != EST_ReadStage::Source) {
+        return;
+    }
+
+    ma_uint64 frames = static_cast<ma_uint64>(sample->sampleRate) * kQueuePrimeMilliseconds / 1000;
+
+    try {
+        sample->prime.resize(frames * sample->channels);
+    } catch (std::bad_alloc &) {
+        return;
+    }
+
+    sample->primeFrames = SampleReadSource(sample, sample->prime.data(), frames);
+    sample->cursor = 0;
+    sample->stage = EST_ReadStage::Prime;
+    sample->stagePosition = 0;
+}
+
+EST_RESULT EST_SampleQueue(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle, EST_AUDIO_HANDLE next, int crossfade)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    auto it = GetSample(device, handle);
+    auto nextSample = GetSample(device, next);
+    if (!it || !nextSample || handle == next) {
+        EST_SetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (crossfade < 0) {
+        EST_SetError("Invalid crossfade");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_QueueEntry entry = {};
+    entry.handle = next;
+    entry.sample = nextSample;
+    entry.crossfade = static_cast<ma_uint64>(crossfade);
+
+    // The crossfade is timed against the length of whatever plays before the new entry
+    std::shared_ptr<EST_AudioSample> previous = it;
+    {
+        std::lock_guard<std::mutex> lock(it->queueLock);
+        if (!it->queue.empty()) {
+            previous = it->queue.back().sample;
+        }
+    }
+
+    // The mixer can't compute it, some backends scan the whole stream for it
+    if (crossfade > 0) {
+        std::lock_guard<std::mutex> lock(previous->sourceLock);
+        entry.length = SampleGetLength(previous.get());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(nextSample->sourceLock);
+        SampleSeekSource(nextSample.get(), 0);
+    }
+
+    // The mixer starts it straight from the handoff, so it gets the reset EST_SamplePlay would do
+    nextSample->pitch->processor->reset();
+
+    try {
+        std::lock_guard<std::mutex> lock(it->queueLock);
+        it->retired.clear();
+        it->queue.push_back(entry);
+    } catch (std::bad_alloc &alloc) {
+        EST_SetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    WorkerPost(&device->worker, [nextSample] {
+        sample_prime(nextSample.get());
+    });
+
+    return EST_OK;
+}
+
+EST_RESULT EST_SampleClearQueue(EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE handle)
+{
+    auto device = reinterpret_cast<EST_AudioDevice *>(devhandle);
+
+    if (!device) {
+        EST_SetError("No context");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    auto it = GetSample(device, handle);
+    if (!it) {
+        EST_SetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::lock_guard<std::mutex> lock(it->queueLock);
+    it->queue.clear();
+    it->retired.clear();
+
+    return EST_OK;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "Internal.h"
+#include "Sample/SampleInternal.h"
+
+namespace {
+    constexpr auto kSeekPollInterval = std::chrono::milliseconds(10); // Bounds a wakeup the mixer's unlocked notify can miss
+} // namespace
+
+static bool worker_has_seeks(EST_AudioWorker *worker)
+{
+    return worker->seekHead.load(std::memory_order_relaxed) != worker->seekTail.load(std::memory_order_acquire);
+}
+
+static void worker_run_seeks(EST_AudioWorker *worker)
+{
+    size_t head = worker->seekHead.load(std::memory_order_relaxed);
+
+    while (head != worker->seekTail.load(std::memory_order_acquire)) {
+        auto &slot = worker->seeks[head % kWorkerSeekSlots];
+        auto  sample = slot.lock();
+        slot.reset();
+
+        worker->seekHead.store(++head, std::memory_order_release);
+
+        // Removed samples are gone already, nothing is left to seek
+        if (sample) {
+            SampleRunSeek(sample.get());
+        }
+    }
+}
+
+static void worker_loop(EST_AudioWorker *worker)
+{
+    while (true) {
+        worker_run_seeks(worker);
+
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->signal.wait_for(lock, kSeekPollInterval, [worker] {
+                return !worker->isRunning || !worker->jobs.empty() || worker_has_seeks(worker);
+            });
+
+            if (worker->jobs.empty()) {
+                if (!worker->isRunning) {
+                    return;
+                }
+
+                continue;
+            }
+
+            job = std::move(worker->jobs.front());
+            worker->jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void WorkerStart(EST_AudioWorker *worker)
+{
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->isRunning) {
+        return;
+    }
+
+    worker->isRunning = true;
+    worker->thread = std::thread(worker_loop, worker);
+}
+
+void WorkerStop(EST_AudioWorker *worker)
+{
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->isRunning = false;
+    }
+
+    worker->signal.notify_all();
+
+    // Pending jobs are still drained before the thread exits
+    if (worker->thread.joinable()) {
+        worker->thread.join();
+    }
+}
+
+void WorkerPost(EST_AudioWorker *worker, std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->jobs.push_back(std::move(job));
+    }
+
+    worker->signal.notify_one();
+}
+
+bool WorkerPostSeek(EST_AudioWorker *worker, const std::shared_ptr<EST_AudioSample> &sample)
+{
+    size_t tail = worker->seekTail.load(std::memory_order_relaxed);
+    if (tail - worker->seekHead.load(std::memory_order_acquire) == kWorkerSeekSlots) {
+        return false;
+    }
+
+    // The worker reset the slot when it took it, so this never frees anything
+    worker->seeks[tail % kWorkerSeekSlots] = sample;
+    worker->seekTail.store(tail + 1, std::memory_order_release);
+
+    worker->signal.notify_one();
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "Analysis.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EST_ANALYSIS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr double kAbsoluteGate = -70.0; // LUFS
+    constexpr double kRelativeGate = -10.0; // LU below the absolutely gated loudness
+    constexpr double kSurroundWeight = 1.41;
+    constexpr size_t kSumChunk = 4096;      // Samples summed in float before moving to double
+
+    // Transposed direct form II, one per channel and stage
+    struct EST_Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+        double a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        inline double Process(double x)
+        {
+            double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+} // namespace
+
+// BS.1770 K-weighting, the published 48 kHz filters re-derived for any rate
+static void k_weighting(int sampleRate, EST_Biquad *shelf, EST_Biquad *highPass)
+{
+    double rate = static_cast<double>(sampleRate);
+
+    {
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+
+        double k = std::tan(kPi * f0 / rate);
+        double vh = std::pow(10.0, gain / 20.0);
+        double vb = std::pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+
+        shelf->b0 = (vh + vb * k / q + k * k) / a0;
+        shelf->b1 = 2.0 * (k * k - vh) / a0;
+        shelf->b2 = (vh - vb * k / q + k * k) / a0;
+        shelf->a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf->a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        double f0 = 38.13547087602444;
+        double q = 0.5003270373238773;
+
+        double k = std::tan(kPi * f0 / rate);
+        double a0 = 1.0 + k / q + k * k;
+
+        highPass->b0 = 1.0;
+        highPass->b1 = -2.0;
+        highPass->b2 = 1.0;
+        highPass->a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass->a2 = (1.0 - k / q + k * k) / a0;
+    }
+}
+
+// BS.1770 channel weight in the default channel order, LFE isn't measured and surrounds count 1.41 times
+static double channel_weight(ma_channel channel)
+{
+    switch (channel) {
+        case MA_CHANNEL_LFE:
+            return 0.0;
+        case MA_CHANNEL_SIDE_LEFT:
+        case MA_CHANNEL_SIDE_RIGHT:
+        case MA_CHANNEL_BACK_LEFT:
+        case MA_CHANNEL_BACK_RIGHT:
+        case MA_CHANNEL_BACK_CENTER:
+            return kSurroundWeight;
+        default:
+            return 1.0;
+    }
+}
+
+static bool frame_is_loud(const float *frame, int channels, float threshold)
+{
+    for (int c = 0; c < channels; c++) {
+        if (std::fabs(frame[c]) > threshold) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Index of the first sample above threshold in [from, to), to when there is none
+static size_t first_loud_sample(const float *samples, size_t from, size_t to, float threshold)
+{
+    size_t i = from;
+
+#if defined(EST_ANALYSIS_SSE2)
+    const __m128 limit = _mm_set1_ps(threshold);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    for (; i + 4 <= to; i += 4) {
+        __m128 values = _mm_and_ps(_mm_loadu_ps(samples + i), absMask);
+        if (_mm_movemask_ps(_mm_cmpgt_ps(values, limit))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < to; i++) {
+        if (std::fabs(samples[i]) > threshold) {
+            return i;
+        }
+    }
+
+    return to;
+}
+
+void FindSoundBounds(const float *frames, ma_uint64 frameCount, int channels, float threshold, ma_uint64 *start, ma_uint64 *end)
+{
+    size_t count = static_cast<size_t>(frameCount * channels);
+    size_t first = first_loud_sample(frames, 0, count, threshold);
+
+    if (first == count) {
+        *start = frameCount;
+        *end = frameCount;
+        return;
+    }
+
+    *start = first / channels;
+
+    // Walk back from the end a frame at a time, trailing silence is usually short next to the sound
+    ma_uint64 last = frameCount;
+    while (last > *start + 1 && !frame_is_loud(frames + (last - 1) * channels, channels, threshold)) {
+        last--;
+    }
+
+    *end = last;
+}
+
+// Peak and sum of squares, partial sums stay short so float lanes don't lose precision
+static void peak_and_energy(const float *samples, size_t count, float *peak, double *energy)
+{
+    float  maxValue = 0.0f;
+    double total = 0.0;
+
+    for (size_t chunk = 0; chunk < count; chunk += kSumChunk) {
+        size_t end = std::min(count, chunk + kSumChunk);
+        size_t i = chunk;
+        float  sum = 0.0f;
+
+#if defined(EST_ANALYSIS_SSE2)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128       maxLanes = _mm_setzero_ps();
+        __m128       sumLanes = _mm_setzero_ps();
+
+        for (; i + 4 <= end; i += 4) {
+            __m128 values = _mm_loadu_ps(samples + i);
+            maxLanes = _mm_max_ps(maxLanes, _mm_and_ps(values, absMask));
+            sumLanes = _mm_add_ps(sumLanes, _mm_mul_ps(values, values));
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, maxLanes);
+        maxValue = std::max({ maxValue, lanes[0], lanes[1], lanes[2], lanes[3] });
+
+        _mm_storeu_ps(lanes, sumLanes);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+        for (; i < end; i++) {
+            maxValue = std::max(maxValue, std::fabs(samples[i]));
+            sum += samples[i] * samples[i];
+        }
+
+        total += sum;
+    }
+
+    *peak = maxValue;
+    *energy = total;
+}
+
+static double block_loudness(double power)
+{
+    return -0.691 + 10.0 * std::log10(power);
+}
+
+void AnalyzeFrames(const float *frames, ma_uint64 frameCount, int channels, int sampleRate, EST_LoudnessStats *stats)
+{
+    size_t count = static_cast<size_t>(frameCount * channels);
+    double energy = 0.0;
+
+    peak_and_energy(frames, count, &stats->peak, &energy);
+    stats->rms = count > 0 ? static_cast<float>(std::sqrt(energy / static_cast<double>(count))) : 0.0f;
+    stats->loudness = -std::numeric_limits<float>::infinity();
+
+    if (frameCount == 0 || sampleRate <= 0) {
+        return;
+    }
+
+    // Mean square of the K-weighted signal per 100 ms step, summed over channels
+    ma_uint64           step = std::max<ma_uint64>(1, static_cast<ma_uint64>(sampleRate) / 10);
+    ma_uint64           stepCount = (frameCount + step - 1) / step;
+    std::vector<double> steps(static_cast<size_t>(stepCount), 0.0);
+
+    ma_channel channelMap[MA_MAX_CHANNELS] = {};
+    if (channels > 2) {
+        ma_channel_map_init_standard(ma_standard_channel_map_default, channelMap, MA_MAX_CHANNELS, static_cast<ma_uint32>(std::min(channels, MA_MAX_CHANNELS)));
+    }
+
+    for (int c = 0; c < channels; c++) {
+        double weight = (channels > 2 && c < MA_MAX_CHANNELS) ? channel_weight(channelMap[c]) : 1.0;
+        if (weight == 0.0) {
+            continue;
+        }
+
+        EST_Biquad shelf;
+        EST_Biquad highPass;
+        k_weighting(sampleRate, &shelf, &highPass);
+
+        for (ma_uint64 i = 0; i < frameCount; i++) {
+            double y = highPass.Process(shelf.Process(frames[i * channels + c]));
+            steps[static_cast<size_t>(i / step)] += weight * y * y;
+        }
+    }
+
+    // 400 ms blocks overlapping by 75 %, a short sound is one block over all of it
+    std::vector<double> blocks;
+
+    if (stepCount < 4) {
+        double sum = 0.0;
+        for (double value : steps) {
+            sum += value;
+        }
+
+        blocks.push_back(sum / static_cast<double>(frameCount));
+    } else {
+        for (ma_uint64 i = 0; i + 4 <= stepCount; i++) {
+            double sum = steps[i] + steps[i + 1] + steps[i + 2] + steps[i + 3];
+
+            // The last step is short when the sound doesn't end on a step boundary
+            ma_uint64 blockFrames = std::min(frameCount, (i + 4) * step) - i * step;
+            blocks.push_back(sum / static_cast<double>(blockFrames));
+        }
+    }
+
+    double gatedSum = 0.0;
+    size_t gatedCount = 0;
+
+    for (double power : blocks) {
+        if (power > 0.0 && block_loudness(power) > kAbsoluteGate) {
+            gatedSum += power;
+            gatedCount++;
+        }
+    }
+
+    if (gatedCount == 0) {
+        return;
+    }
+
+    double relativeGate = block_loudness(gatedSum / static_cast<double>(gatedCount)) + kRelativeGate;
+
+    gatedSum = 0.0;
+    gatedCount = 0;
+
+    for (double power : blocks) {
+        if (power > 0.0 && block_loudness(power) > kAbsoluteGate && block_loudness(power) > relativeGate) {
+            gatedSum += power;
+            gatedCount++;
+        }
+    }
+
+    if (gatedCount > 0) {
+        stats->loudness = static_cast<float>(block_loudness(gatedSum / static_cast<double>(gatedCount)));
+    }
+}
\ No newline at end of file
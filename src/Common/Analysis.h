@@ -0,0 +1,21 @@
+#ifndef __COMMON_ANALYSIS_H_
+#define __COMMON_ANALYSIS_H_
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+
+struct EST_LoudnessStats
+{
+    float peak = 0.0f;     // Largest absolute sample, linear full scale
+    float rms = 0.0f;      // Over every sample of every channel, linear full scale
+    float loudness = 0.0f; // Integrated loudness (ITU-R BS.1770), LUFS
+};
+
+// The frames [start, end) span every frame where some channel exceeds threshold (linear),
+// start == end when none does
+void FindSoundBounds(const float *frames, ma_uint64 frameCount, int channels, float threshold, ma_uint64 *start, ma_uint64 *end);
+
+// Sounds shorter than one 400 ms gating block are measured as a single block. Past stereo the
+// loudness takes the default channel order, skipping LFE and weighting surrounds as BS.1770 does
+void AnalyzeFrames(const float *frames, ma_uint64 frameCount, int channels, int sampleRate, EST_LoudnessStats *stats);
+
+#endif
\ No newline at end of file
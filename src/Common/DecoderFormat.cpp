@@ -0,0 +1,216 @@
+#include "DecoderFormat.h"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+    constexpr size_t    kProbeSize = 64;
+    constexpr size_t    kOggPacketOffset = 28; // First packet of the first page, after a single segment table entry
+    constexpr ma_uint32 kMp3SeekPoints = 512;  // Seek table built at load, keeps MP3 seeks from decoding from the start
+} // namespace
+
+static enum EST_AUDIO_FORMAT format_from_extension(const char *path)
+{
+    if (!path) {
+        return EST_FORMAT_AUTO;
+    }
+
+    const char *dot = std::strrchr(path, '.');
+    if (!dot) {
+        return EST_FORMAT_AUTO;
+    }
+
+    std::string extension(dot + 1);
+    for (auto &c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    if (extension == "wav" || extension == "wave") {
+        return EST_FORMAT_WAV;
+    }
+
+    if (extension == "flac") {
+        return EST_FORMAT_FLAC;
+    }
+
+    if (extension == "mp3") {
+        return EST_FORMAT_MP3;
+    }
+
+    if (extension == "opus") {
+        return EST_FORMAT_OPUS;
+    }
+
+    // .ogg can hold either codec, leave it to the probe
+    return EST_FORMAT_AUTO;
+}
+
+enum EST_AUDIO_FORMAT DetectFormat(const void *data, size_t size, const char *path)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+
+    if (bytes && size >= 12) {
+        if ((std::memcmp(bytes, "RIFF", 4) == 0 || std::memcmp(bytes, "RF64", 4) == 0) && std::memcmp(bytes + 8, "WAVE", 4) == 0) {
+            return EST_FORMAT_WAV;
+        }
+
+        if (std::memcmp(bytes, "fLaC", 4) == 0) {
+            return EST_FORMAT_FLAC;
+        }
+
+        if (std::memcmp(bytes, "OggS", 4) == 0 && size >= kOggPacketOffset + 8) {
+            const unsigned char *packet = bytes + kOggPacketOffset;
+
+            if (std::memcmp(packet, "\x01vorbis", 7) == 0) {
+                return EST_FORMAT_VORBIS;
+            }
+
+            if (std::memcmp(packet, "OpusHead", 8) == 0) {
+                return EST_FORMAT_OPUS;
+            }
+
+            return EST_FORMAT_AUTO;
+        }
+
+        if (std::memcmp(bytes, "ID3", 3) == 0) {
+            return EST_FORMAT_MP3;
+        }
+
+        // MPEG audio frame sync with a non-zero layer, ADTS AAC uses layer 0
+        if (bytes[0] == 0xFF && (bytes[1] & 0xE0) == 0xE0 && (bytes[1] & 0x06) != 0) {
+            return EST_FORMAT_MP3;
+        }
+    }
+
+    return format_from_extension(path);
+}
+
+enum EST_AUDIO_FORMAT DetectFileFormat(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return format_from_extension(path);
+    }
+
+    unsigned char header[kProbeSize] = {};
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+
+    return DetectFormat(header, static_cast<size_t>(file.gcount()), path);
+}
+
+// Reads the leading bytes through the VFS, the decoder reopens it from the start afterwards
+static enum EST_AUDIO_FORMAT detect_vfs_format(ma_vfs *vfs, const char *path)
+{
+    ma_vfs_file file;
+    if (ma_vfs_open(vfs, path, MA_OPEN_MODE_READ, &file) != MA_SUCCESS) {
+        return format_from_extension(path);
+    }
+
+    unsigned char header[kProbeSize] = {};
+    size_t        bytesRead = 0;
+    ma_vfs_read(vfs, file, header, sizeof(header), &bytesRead);
+    ma_vfs_close(vfs, file);
+
+    return DetectFormat(header, bytesRead, path);
+}
+
+// Narrows the config to the backends the format needs, vtables must outlive the decoder init
+static void decoder_apply_format(ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoding_backend_vtable **vtables)
+{
+    config->pCustomBackendUserData = NULL;
+    config->ppCustomBackendVTables = vtables;
+    config->customBackendCount = 0;
+    config->encodingFormat = ma_encoding_format_unknown;
+
+    bool isSeekTableShared = config->seekPointCount == kDecoderSharedSeekTable;
+    if (isSeekTableShared) {
+        config->seekPointCount = 0;
+    }
+
+    switch (format) {
+        case EST_FORMAT_WAV:
+            config->encodingFormat = ma_encoding_format_wav;
+            break;
+        case EST_FORMAT_FLAC:
+            config->encodingFormat = ma_encoding_format_flac;
+            break;
+        case EST_FORMAT_MP3:
+            config->encodingFormat = ma_encoding_format_mp3;
+            if (config->seekPointCount == 0 && !isSeekTableShared) {
+                config->seekPointCount = kMp3SeekPoints;
+            }
+            break;
+        case EST_FORMAT_VORBIS:
+            vtables[0] = &g_ma_decoding_backend_vtable_libvorbis;
+            config->customBackendCount = 1;
+            break;
+        case EST_FORMAT_OPUS:
+            vtables[0] = &g_ma_decoding_backend_vtable_libopus;
+            config->customBackendCount = 1;
+            break;
+        default:
+            vtables[0] = &g_ma_decoding_backend_vtable_libvorbis;
+            vtables[1] = &g_ma_decoding_backend_vtable_libopus;
+            config->customBackendCount = 2;
+            break;
+    }
+}
+
+ma_result DecoderInitFile(const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder)
+{
+    if (format == EST_FORMAT_AUTO) {
+        format = DetectFileFormat(path);
+    }
+
+    ma_decoding_backend_vtable *pCustomBackendVTables[2] = {};
+    ma_decoder_config           hinted = *config;
+    decoder_apply_format(&hinted, format, pCustomBackendVTables);
+
+    ma_result result = ma_decoder_init_file(path, &hinted, decoder);
+    if (result == MA_SUCCESS || format == EST_FORMAT_AUTO) {
+        return result;
+    }
+
+    // Misnamed or mislabeled file, probe everything
+    decoder_apply_format(&hinted, EST_FORMAT_AUTO, pCustomBackendVTables);
+    return ma_decoder_init_file(path, &hinted, decoder);
+}
+
+ma_result DecoderInitMemory(const void *data, size_t size, const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder)
+{
+    if (format == EST_FORMAT_AUTO) {
+        format = DetectFormat(data, size, path);
+    }
+
+    ma_decoding_backend_vtable *pCustomBackendVTables[2] = {};
+    ma_decoder_config           hinted = *config;
+    decoder_apply_format(&hinted, format, pCustomBackendVTables);
+
+    ma_result result = ma_decoder_init_memory(data, size, &hinted, decoder);
+    if (result == MA_SUCCESS || format == EST_FORMAT_AUTO) {
+        return result;
+    }
+
+    decoder_apply_format(&hinted, EST_FORMAT_AUTO, pCustomBackendVTables);
+    return ma_decoder_init_memory(data, size, &hinted, decoder);
+}
+
+ma_result DecoderInitVFS(ma_vfs *vfs, const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder)
+{
+    if (format == EST_FORMAT_AUTO) {
+        format = detect_vfs_format(vfs, path);
+    }
+
+    ma_decoding_backend_vtable *pCustomBackendVTables[2] = {};
+    ma_decoder_config           hinted = *config;
+    decoder_apply_format(&hinted, format, pCustomBackendVTables);
+
+    ma_result result = ma_decoder_init_vfs(vfs, path, &hinted, decoder);
+    if (result == MA_SUCCESS || format == EST_FORMAT_AUTO) {
+        return result;
+    }
+
+    decoder_apply_format(&hinted, EST_FORMAT_AUTO, pCustomBackendVTables);
+    return ma_decoder_init_vfs(vfs, path, &hinted, decoder);
+}
\ No newline at end of file
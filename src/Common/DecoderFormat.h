@@ -0,0 +1,27 @@
+#ifndef __COMMON_DECODER_FORMAT_H_
+#define __COMMON_DECODER_FORMAT_H_
+
+#include <EstTypes.h>
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+#include <cstddef>
+
+// seekPointCount for decoders that borrow an MP3 seek table instead of scanning the file for their own
+constexpr ma_uint32 kDecoderSharedSeekTable = ~0u;
+
+// Guesses the container from the leading bytes, falling back to the path extension
+// Returns EST_FORMAT_AUTO when neither is conclusive
+enum EST_AUDIO_FORMAT DetectFormat(const void *data, size_t size, const char *path);
+
+// Reads the leading bytes of the file and detects its format
+enum EST_AUDIO_FORMAT DetectFileFormat(const char *path);
+
+// Opens the decoder with only the backend the format needs, and falls back to
+// probing every backend when the hint turns out wrong. EST_FORMAT_AUTO detects first.
+ma_result DecoderInitFile(const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder);
+ma_result DecoderInitMemory(const void *data, size_t size, const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder);
+
+// Streams through the VFS, path only names the file to it and hints the extension
+ma_result DecoderInitVFS(ma_vfs *vfs, const char *path, const ma_decoder_config *config, enum EST_AUDIO_FORMAT format, ma_decoder *decoder);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    struct EST_MappedFileDestructor
+    {
+        inline void operator()(EST_MappedFile *file) const
+        {
+#if defined(_WIN32)
+            if (file->data) {
+                UnmapViewOfFile(file->data);
+            }
+
+            if (file->mapping) {
+                CloseHandle(file->mapping);
+            }
+
+            if (file->file) {
+                CloseHandle(file->file);
+            }
+#else
+            if (file->data) {
+                munmap(const_cast<unsigned char *>(file->data), file->size);
+            }
+#endif
+
+            delete file;
+        }
+    };
+} // namespace
+
+void MapAdvise(EST_MappedFile *file, int flags)
+{
+#if !defined(_WIN32)
+    if (flags & EST_MAP_WILLNEED) {
+        madvise(const_cast<unsigned char *>(file->data), file->size, MADV_WILLNEED);
+    }
+
+    if (flags & EST_MAP_SEQUENTIAL) {
+        madvise(const_cast<unsigned char *>(file->data), file->size, MADV_SEQUENTIAL);
+    }
+#else
+    (void)file;
+    (void)flags;
+#endif
+}
+
+std::shared_ptr<EST_MappedFile> MapFile(const char *path, int flags, const char **error)
+{
+    std::shared_ptr<EST_MappedFile> file;
+
+    try {
+        file = std::shared_ptr<EST_MappedFile>(new EST_MappedFile, EST_MappedFileDestructor{});
+    } catch (std::bad_alloc &) {
+        *error = "Out of memory!";
+        return nullptr;
+    }
+
+#if defined(_WIN32)
+    DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+    if (flags & EST_MAP_SEQUENTIAL) {
+        attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+    }
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, attributes, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        *error = "Failed to open file";
+        return nullptr;
+    }
+
+    file->file = handle;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        *error = "Failed to map empty file";
+        return nullptr;
+    }
+
+    file->mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!file->mapping) {
+        *error = "Failed to map file";
+        return nullptr;
+    }
+
+    file->data = static_cast<const unsigned char *>(MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!file->data) {
+        *error = "Failed to map file";
+        return nullptr;
+    }
+
+    file->size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *error = "Failed to open file";
+        return nullptr;
+    }
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        *error = "Failed to map empty file";
+        return nullptr;
+    }
+
+    int mapFlags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (flags & EST_MAP_POPULATE) {
+        mapFlags |= MAP_POPULATE;
+    }
+#endif
+
+    void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, mapFlags, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        *error = "Failed to map file";
+        return nullptr;
+    }
+
+    file->data = static_cast<const unsigned char *>(data);
+    file->size = static_cast<size_t>(info.st_size);
+#endif
+
+    MapAdvise(file.get(), flags);
+    return file;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __COMMON_MAPPED_FILE_H_
+#define __COMMON_MAPPED_FILE_H_
+
+#include <EstTypes.h>
+
+#include <cstddef>
+#include <memory>
+
+// Read-only mapping of a whole file, unmapped with the last reference
+struct EST_MappedFile
+{
+    const unsigned char *data = nullptr;
+    size_t               size = 0;
+
+#if defined(_WIN32)
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+};
+
+// Maps path with the EST_MAP_FLAGS hints, null with error set on failure
+std::shared_ptr<EST_MappedFile> MapFile(const char *path, int flags, const char **error);
+
+// Applies the access hints to a mapping again, another user may want different ones
+void MapAdvise(EST_MappedFile *file, int flags);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,436 @@
+#include "PackedPCM.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EST_PACKED_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr float kS16Scale = 1.0f / 32768.0f;
+
+    constexpr int kAdpcmStepTable[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+        107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+        4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+        22385, 24623, 27086, 29794, 32767
+    };
+
+    constexpr int kAdpcmIndexTable[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+    // Predictor and step index, the same on the encoding and decoding side
+    struct EST_AdpcmState
+    {
+        int predictor = 0;
+        int index = 0;
+    };
+} // namespace
+
+static int16_t to_s16(float value)
+{
+    return static_cast<int16_t>(std::lrintf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Round to nearest even, overflow saturates to infinity and NaN stays NaN
+static uint16_t to_f16(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= (127u + 16u) << 23) {
+        half = bits > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if (bits < (113u << 23)) {
+        // Subnormal or zero, let the float adder round the mantissa into place
+        const uint32_t magicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+        float          magic;
+        float          shifted;
+
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+
+        half = static_cast<uint16_t>(bits - magicBits);
+    } else {
+        uint32_t odd = (bits >> 13) & 1u;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + odd;
+        half = static_cast<uint16_t>(bits >> 13);
+    }
+
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+// Scales the exponent with a float multiply, which also normalizes subnormals
+static float from_f16(uint16_t half)
+{
+    const uint32_t magicBits = (254u - 15u) << 23;
+    float          magic;
+    std::memcpy(&magic, &magicBits, sizeof(magic));
+
+    uint32_t expMantissa = half & 0x7fffu;
+    uint32_t shifted = expMantissa << 13;
+    float    scaled;
+
+    std::memcpy(&scaled, &shifted, sizeof(scaled));
+    scaled *= magic;
+
+    uint32_t bits;
+    std::memcpy(&bits, &scaled, sizeof(bits));
+
+    if (expMantissa > 0x7bffu) {
+        bits |= 255u << 23;
+    }
+
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int adpcm_decode_nibble(EST_AdpcmState *state, int nibble)
+{
+    int step = kAdpcmStepTable[state->index];
+    int diff = step >> 3;
+
+    if (nibble & 4) {
+        diff += step;
+    }
+
+    if (nibble & 2) {
+        diff += step >> 1;
+    }
+
+    if (nibble & 1) {
+        diff += step >> 2;
+    }
+
+    state->predictor = std::clamp(nibble & 8 ? state->predictor - diff : state->predictor + diff, -32768, 32767);
+    state->index = std::clamp(state->index + kAdpcmIndexTable[nibble], 0, 88);
+
+    return state->predictor;
+}
+
+static int adpcm_encode_sample(EST_AdpcmState *state, int sample)
+{
+    int step = kAdpcmStepTable[state->index];
+    int diff = sample - state->predictor;
+    int nibble = 0;
+
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+
+    if (diff >= step >> 1) {
+        nibble |= 2;
+        diff -= step >> 1;
+    }
+
+    if (diff >= step >> 2) {
+        nibble |= 1;
+    }
+
+    // Track exactly what the decoder will reconstruct
+    adpcm_decode_nibble(state, nibble);
+    return nibble;
+}
+
+// Start index whose step is closest to the first difference, keeps the block attack clean
+static int adpcm_initial_index(const float *frames, ma_uint64 frameCount, int channels, int channel)
+{
+    if (frameCount < 2) {
+        return 0;
+    }
+
+    int diff = std::abs(to_s16(frames[channels + channel]) - to_s16(frames[channel]));
+    int index = 0;
+
+    while (index < 88 && kAdpcmStepTable[index] < diff) {
+        index++;
+    }
+
+    return index;
+}
+
+// Block layout: per channel { int16 predictor, uint8 index, uint8 0 }, then per channel kAdpcmBlockFrames / 2 bytes
+static void adpcm_encode_block(const float *frames, ma_uint64 frameCount, int channels, unsigned char *block)
+{
+    unsigned char *data = block + 4 * channels;
+
+    for (int c = 0; c < channels; c++) {
+        EST_AdpcmState state;
+        state.predictor = to_s16(frames[c]);
+        state.index = adpcm_initial_index(frames, frameCount, channels, c);
+
+        block[4 * c] = static_cast<unsigned char>(state.predictor & 0xff);
+        block[4 * c + 1] = static_cast<unsigned char>((state.predictor >> 8) & 0xff);
+        block[4 * c + 2] = static_cast<unsigned char>(state.index);
+        block[4 * c + 3] = 0;
+
+        unsigned char *nibbles = data + c * (kAdpcmBlockFrames / 2);
+
+        for (ma_uint64 i = 0; i < kAdpcmBlockFrames; i++) {
+            // The last block is padded by holding the final value
+            ma_uint64 frame = std::min(i, frameCount - 1);
+            int       nibble = adpcm_encode_sample(&state, to_s16(frames[frame * channels + c]));
+
+            if (i & 1) {
+                nibbles[i / 2] |= static_cast<unsigned char>(nibble << 4);
+            } else {
+                nibbles[i / 2] = static_cast<unsigned char>(nibble);
+            }
+        }
+    }
+}
+
+size_t AdpcmBlockSize(int channels)
+{
+    return static_cast<size_t>(channels) * (4 + kAdpcmBlockFrames / 2);
+}
+
+size_t PackedSize(enum EST_SAMPLE_STORAGE storage, ma_uint64 frameCount, int channels)
+{
+    switch (storage) {
+        case EST_STORAGE_S16:
+        case EST_STORAGE_F16:
+            return static_cast<size_t>(frameCount * channels * 2);
+        case EST_STORAGE_ADPCM:
+            return static_cast<size_t>((frameCount + kAdpcmBlockFrames - 1) / kAdpcmBlockFrames) * AdpcmBlockSize(channels);
+        default:
+            return static_cast<size_t>(frameCount * channels * sizeof(float));
+    }
+}
+
+void PackFrames(enum EST_SAMPLE_STORAGE storage, const float *frames, ma_uint64 frameCount, int channels, std::vector<unsigned char> &packed)
+{
+    packed.resize(PackedSize(storage, frameCount, channels));
+
+    size_t count = static_cast<size_t>(frameCount * channels);
+
+    switch (storage) {
+        case EST_STORAGE_S16:
+            for (size_t i = 0; i < count; i++) {
+                int16_t value = to_s16(frames[i]);
+                std::memcpy(&packed[i * 2], &value, sizeof(value));
+            }
+            break;
+        case EST_STORAGE_F16:
+            for (size_t i = 0; i < count; i++) {
+                uint16_t value = to_f16(frames[i]);
+                std::memcpy(&packed[i * 2], &value, sizeof(value));
+            }
+            break;
+        case EST_STORAGE_ADPCM:
+            for (ma_uint64 frame = 0, block = 0; frame < frameCount; frame += kAdpcmBlockFrames, block++) {
+                adpcm_encode_block(frames + frame * channels, std::min(kAdpcmBlockFrames, frameCount - frame), channels, &packed[block * AdpcmBlockSize(channels)]);
+            }
+            break;
+        default:
+            std::memcpy(packed.data(), frames, packed.size());
+            break;
+    }
+}
+
+// Uniform in [-0.5, 0.5) from the top 24 bits of the next xorshift value
+static float dither_draw(uint32_t &lane)
+{
+    lane ^= lane << 13;
+    lane ^= lane >> 17;
+    lane ^= lane << 5;
+    return static_cast<float>(lane >> 8) * (1.0f / 16777216.0f) - 0.5f;
+}
+
+#if defined(EST_PACKED_SSE2)
+static __m128 dither_draw(__m128i &lanes)
+{
+    lanes = _mm_xor_si128(lanes, _mm_slli_epi32(lanes, 13));
+    lanes = _mm_xor_si128(lanes, _mm_srli_epi32(lanes, 17));
+    lanes = _mm_xor_si128(lanes, _mm_slli_epi32(lanes, 5));
+    return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(lanes, 8)), _mm_set1_ps(1.0f / 16777216.0f)), _mm_set1_ps(0.5f));
+}
+#endif
+
+// Scaled, clamped and rounded samples, count is at most kQuantizeBlock
+static void quantize_block(const float *src, int32_t *dst, size_t count, int bits, EST_Dither *dither)
+{
+    const float scale = static_cast<float>(1u << (bits - 1));
+    const float low = -scale;
+    const float high = bits == 32 ? 2147483520.0f : scale - 1.0f; // The largest float below 2^31
+
+    size_t i = 0;
+
+#if defined(EST_PACKED_SSE2)
+    const __m128 vScale = _mm_set1_ps(scale);
+    const __m128 vLow = _mm_set1_ps(low);
+    const __m128 vHigh = _mm_set1_ps(high);
+
+    if (dither) {
+        __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dither->lanes));
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 noise = _mm_add_ps(dither_draw(lanes), dither_draw(lanes));
+            __m128 value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vScale), noise);
+
+            value = _mm_min_ps(_mm_max_ps(value, vLow), vHigh);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_cvtps_epi32(value));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dither->lanes), lanes);
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            __m128 value = _mm_mul_ps(_mm_loadu_ps(src + i), vScale);
+
+            value = _mm_min_ps(_mm_max_ps(value, vLow), vHigh);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_cvttps_epi32(value));
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (dither) {
+            float noise = dither_draw(dither->lanes[i & 3]) + dither_draw(dither->lanes[i & 3]);
+            dst[i] = static_cast<int32_t>(std::lrintf(std::clamp(src[i] * scale + noise, low, high)));
+        } else {
+            dst[i] = static_cast<int32_t>(std::clamp(src[i] * scale, low, high));
+        }
+    }
+}
+
+void QuantizeSamples(const float *src, unsigned char *dst, size_t count, int bits, EST_Dither *dither)
+{
+    constexpr size_t kQuantizeBlock = 256;
+
+    int32_t values[kQuantizeBlock];
+
+    if (bits == 32) {
+        dither = nullptr;
+    }
+
+    for (size_t offset = 0; offset < count; offset += kQuantizeBlock) {
+        size_t block = std::min(kQuantizeBlock, count - offset);
+
+        quantize_block(src + offset, values, block, bits, dither);
+
+        size_t         i = 0;
+        unsigned char *out = dst + offset * (bits / 8);
+
+        switch (bits) {
+            case 16:
+#if defined(EST_PACKED_SSE2)
+                // Values are in range already, the saturating pack only narrows
+                for (; i + 8 <= block; i += 8) {
+                    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+                    __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i + 4));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2), _mm_packs_epi32(first, second));
+                }
+#endif
+                for (; i < block; i++) {
+                    int16_t value = static_cast<int16_t>(values[i]);
+                    std::memcpy(out + i * 2, &value, sizeof(value));
+                }
+                break;
+            case 24:
+                for (; i < block; i++) {
+                    uint32_t value = static_cast<uint32_t>(values[i]);
+                    out[i * 3] = static_cast<unsigned char>(value);
+                    out[i * 3 + 1] = static_cast<unsigned char>(value >> 8);
+                    out[i * 3 + 2] = static_cast<unsigned char>(value >> 16);
+                }
+                break;
+            default:
+                std::memcpy(out, values, block * sizeof(int32_t));
+                break;
+        }
+    }
+}
+
+void UnpackS16(const unsigned char *src, float *dst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(EST_PACKED_SSE2)
+    const __m128 scale = _mm_set1_ps(kS16Scale);
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+
+        // Duplicate into the high halves and shift back down to sign extend
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#endif
+
+    for (; i < count; i++) {
+        int16_t value;
+        std::memcpy(&value, src + i * 2, sizeof(value));
+        dst[i] = static_cast<float>(value) * kS16Scale;
+    }
+}
+
+void UnpackF16(const unsigned char *src, float *dst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(EST_PACKED_SSE2)
+    const __m128i maskNoSign = _mm_set1_epi32(0x7fff);
+    const __m128  magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128i wasInfNan = _mm_set1_epi32(0x7bff);
+    const __m128i expInfNan = _mm_set1_epi32(255 << 23);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+        __m128i halves[2] = { _mm_unpacklo_epi16(values, zero), _mm_unpackhi_epi16(values, zero) };
+
+        for (int part = 0; part < 2; part++) {
+            __m128i expMantissa = _mm_and_si128(halves[part], maskNoSign);
+            __m128i sign = _mm_slli_epi32(_mm_xor_si128(halves[part], expMantissa), 16);
+            __m128  scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), magic);
+            __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMantissa, wasInfNan), expInfNan);
+
+            _mm_storeu_ps(dst + i + part * 4, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan))));
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        uint16_t value;
+        std::memcpy(&value, src + i * 2, sizeof(value));
+        dst[i] = from_f16(value);
+    }
+}
+
+void AdpcmDecodeBlock(const unsigned char *block, int channels, float *dst)
+{
+    const unsigned char *data = block + 4 * channels;
+
+    for (int c = 0; c < channels; c++) {
+        EST_AdpcmState state;
+        state.predictor = static_cast<int16_t>(block[4 * c] | (block[4 * c + 1] << 8));
+        state.index = std::min<int>(block[4 * c + 2], 88);
+
+        const unsigned char *nibbles = data + c * (kAdpcmBlockFrames / 2);
+
+        for (ma_uint64 i = 0; i < kAdpcmBlockFrames; i++) {
+            int nibble = (i & 1) ? nibbles[i / 2] >> 4 : nibbles[i / 2] & 0x0f;
+            dst[i * channels + c] = static_cast<float>(adpcm_decode_nibble(&state, nibble)) * kS16Scale;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __COMMON_PACKED_PCM_H_
+#define __COMMON_PACKED_PCM_H_
+
+#include <EstTypes.h>
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// IMA ADPCM is stored in independent blocks so any frame is reachable by decoding one block
+constexpr ma_uint64 kAdpcmBlockFrames = 256;
+
+// Bytes of one ADPCM block, a 4 byte state header and kAdpcmBlockFrames nibbles per channel
+size_t AdpcmBlockSize(int channels);
+
+// Bytes frameCount frames take in the storage format
+size_t PackedSize(enum EST_SAMPLE_STORAGE storage, ma_uint64 frameCount, int channels);
+
+// Converts interleaved f32 frames, packed is resized to fit (throws std::bad_alloc)
+void PackFrames(enum EST_SAMPLE_STORAGE storage, const float *frames, ma_uint64 frameCount, int channels, std::vector<unsigned char> &packed);
+
+// Converts count samples back to float, vectorized where the target supports it
+void UnpackS16(const unsigned char *src, float *dst, size_t count);
+void UnpackF16(const unsigned char *src, float *dst, size_t count);
+
+// TPDF dither generator, four xorshift lanes so a whole vector of samples draws at once
+struct EST_Dither
+{
+    uint32_t lanes[4] = { 0x9E3779B9u, 0x85EBCA6Bu, 0xC2B2AE35u, 0x27D4EB2Fu };
+};
+
+// Converts count samples to little endian integer PCM of bits (16, 24 or 32), clamped to full scale
+// Without dither the value truncates, with it one LSB of triangular noise is added before rounding.
+// 32 bit keeps all of the float precision so it is never dithered.
+void QuantizeSamples(const float *src, unsigned char *dst, size_t count, int bits, EST_Dither *dither);
+
+// Decodes a whole block to kAdpcmBlockFrames interleaved frames
+void AdpcmDecodeBlock(const unsigned char *block, int channels, float *dst);
+
+#endif
\ No newline at end of file
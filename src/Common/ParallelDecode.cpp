@@ -0,0 +1,238 @@
+#include "ParallelDecode.h"
+#include "DecoderFormat.h"
+#include "SeekIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+namespace {
+    constexpr ma_uint64 kMinSegmentSeconds = 10; // Shorter ranges spend more on opening and seeking than they save
+    constexpr ma_uint64 kReadChunkFrames = 4096;
+
+    struct EST_DecodeRange
+    {
+        ma_uint64 start = 0;
+        ma_uint64 count = 0;
+        ma_uint64 framesRead = 0;
+        ma_result result = MA_SUCCESS;
+
+        std::vector<float> overflow; // Last range only, frames past the reported length
+    };
+} // namespace
+
+// Range decoders pass the first decoder as shared and borrow its MP3 seek table and Ogg index,
+// so the file is only scanned once however many ranges open it
+static ma_result decode_open(const EST_DecodeSource &source, const std::vector<ma_ogg_seek_point> &seekIndex, const ma_decoder *shared, ma_decoder *decoder)
+{
+    // Native rate and layout, resampling per range would not line up at the seams
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    if (shared) {
+        config.seekPointCount = kDecoderSharedSeekTable;
+    }
+
+    ma_result result = source.path
+                           ? DecoderInitFile(source.path, &config, source.format, decoder)
+                           : DecoderInitMemory(source.data, source.size, nullptr, &config, source.format, decoder);
+
+    if (result == MA_SUCCESS && !seekIndex.empty()) {
+        DecoderBindSeekIndex(decoder, seekIndex);
+    }
+
+    if (result == MA_SUCCESS && shared) {
+        DecoderShareSeekTable(shared, decoder);
+    }
+
+    return result;
+}
+
+static ma_result decode_serial(ma_decoder *decoder, std::vector<float> &frames)
+{
+    ma_uint32 channels = decoder->outputChannels;
+    ma_uint64 total = 0;
+
+    try {
+        while (true) {
+            frames.resize((total + kReadChunkFrames) * channels);
+
+            ma_uint64 framesRead = 0;
+            ma_result result = ma_decoder_read_pcm_frames(decoder, &frames[total * channels], kReadChunkFrames, &framesRead);
+            total += framesRead;
+
+            if (result != MA_SUCCESS || framesRead < kReadChunkFrames) {
+                break;
+            }
+        }
+
+        frames.resize(total * channels);
+        frames.shrink_to_fit();
+    } catch (std::bad_alloc &) {
+        frames.clear();
+        return MA_OUT_OF_MEMORY;
+    }
+
+    return MA_SUCCESS;
+}
+
+static void decode_range(ma_decoder *decoder, EST_DecodeRange *range, float *pOutput, bool isLast)
+{
+    ma_uint32 channels = decoder->outputChannels;
+
+    if (ma_decoder_seek_to_pcm_frame(decoder, range->start) != MA_SUCCESS) {
+        range->result = MA_ERROR;
+        return;
+    }
+
+    while (range->framesRead < range->count) {
+        ma_uint64 framesToRead = std::min(kReadChunkFrames, range->count - range->framesRead);
+        ma_uint64 framesRead = 0;
+
+        ma_decoder_read_pcm_frames(decoder, pOutput + range->framesRead * channels, framesToRead, &framesRead);
+        range->framesRead += framesRead;
+
+        if (framesRead < framesToRead) {
+            return;
+        }
+    }
+
+    if (!isLast) {
+        return;
+    }
+
+    // Reported lengths can come up short (VBR estimates), keep decoding to the real end
+    try {
+        std::vector<float> chunk(kReadChunkFrames * channels);
+
+        while (true) {
+            ma_uint64 framesRead = 0;
+            ma_decoder_read_pcm_frames(decoder, chunk.data(), kReadChunkFrames, &framesRead);
+            range->overflow.insert(range->overflow.end(), chunk.begin(), chunk.begin() + framesRead * channels);
+
+            if (framesRead < kReadChunkFrames) {
+                break;
+            }
+        }
+    } catch (std::bad_alloc &) {
+        range->result = MA_OUT_OF_MEMORY;
+    }
+}
+
+ma_result DecodeParallel(const EST_DecodeSource &source, unsigned int threadCount, std::vector<float> &frames, ma_uint32 *channels, ma_uint32 *sampleRate)
+{
+    std::vector<ma_ogg_seek_point> seekIndex;
+    ma_decoder                     decoder = {};
+
+    ma_result result = decode_open(source, seekIndex, nullptr, &decoder);
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    *channels = decoder.outputChannels;
+    *sampleRate = decoder.outputSampleRate;
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+
+    ma_uint64 minSegment = kMinSegmentSeconds * decoder.outputSampleRate;
+    ma_uint64 segments = minSegment > 0 ? std::min<ma_uint64>(threadCount, length / minSegment) : 0;
+
+    if (segments < 2) {
+        result = decode_serial(&decoder, frames);
+        ma_decoder_uninit(&decoder);
+        return result;
+    }
+
+    // Every range decoder shares one page index, Ogg seeks would bisect otherwise
+    if (DecoderIsOgg(&decoder)) {
+        bool isIndexed = source.path ? BuildOggSeekIndexFile(source.path, seekIndex) : BuildOggSeekIndex(source.data, source.size, seekIndex);
+        if (isIndexed) {
+            DecoderBindSeekIndex(&decoder, seekIndex);
+        }
+    }
+
+    std::vector<EST_DecodeRange> ranges;
+
+    try {
+        frames.assign(length * decoder.outputChannels, 0.0f);
+        ranges.resize(segments);
+    } catch (std::bad_alloc &) {
+        frames.clear();
+        ma_decoder_uninit(&decoder);
+        return MA_OUT_OF_MEMORY;
+    }
+
+    ma_uint64 rangeLength = length / segments;
+    for (ma_uint64 i = 0; i < segments; i++) {
+        ranges[i].start = i * rangeLength;
+        ranges[i].count = (i + 1 == segments) ? length - ranges[i].start : rangeLength;
+    }
+
+    std::vector<std::thread> threads;
+    std::atomic<bool>        isFailed = false;
+
+    try {
+        threads.reserve(segments - 1);
+
+        for (ma_uint64 i = 1; i < segments; i++) {
+            threads.emplace_back([&, i] {
+                ma_decoder rangeDecoder = {};
+                if (decode_open(source, seekIndex, &decoder, &rangeDecoder) != MA_SUCCESS) {
+                    isFailed = true;
+                    return;
+                }
+
+                if (rangeDecoder.outputChannels != *channels) {
+                    isFailed = true;
+                    ma_decoder_uninit(&rangeDecoder);
+                    return;
+                }
+
+                decode_range(&rangeDecoder, &ranges[i], &frames[ranges[i].start * *channels], i + 1 == segments);
+                ma_decoder_uninit(&rangeDecoder);
+            });
+        }
+    } catch (std::exception &) {
+        // Out of threads or memory, the missing ranges fail and decode serially below
+        isFailed = true;
+    }
+
+    // The first range runs on this thread with the decoder that is already open
+    decode_range(&decoder, &ranges[0], frames.data(), false);
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    bool isComplete = !isFailed;
+    for (ma_uint64 i = 0; i < segments && isComplete; i++) {
+        bool isLast = i + 1 == segments;
+        isComplete = ranges[i].result == MA_SUCCESS && (isLast || ranges[i].framesRead == ranges[i].count);
+    }
+
+    if (!isComplete) {
+        // A backend that can't seek exactly, decode the plain way
+        ma_decoder_seek_to_pcm_frame(&decoder, 0);
+        result = decode_serial(&decoder, frames);
+        ma_decoder_uninit(&decoder);
+        return result;
+    }
+
+    ma_decoder_uninit(&decoder);
+
+    EST_DecodeRange &last = ranges.back();
+    ma_uint64        total = last.start + last.framesRead;
+
+    try {
+        frames.resize(total * *channels);
+        frames.insert(frames.end(), last.overflow.begin(), last.overflow.end());
+    } catch (std::bad_alloc &) {
+        frames.clear();
+        return MA_OUT_OF_MEMORY;
+    }
+
+    return MA_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef __COMMON_PARALLEL_DECODE_H_
+#define __COMMON_PARALLEL_DECODE_H_
+
+#include <EstTypes.h>
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+#include <cstddef>
+#include <vector>
+
+// Where to decode from, either path or data is set
+struct EST_DecodeSource
+{
+    const char           *path = nullptr;
+    const void           *data = nullptr;
+    size_t                size = 0;
+    enum EST_AUDIO_FORMAT format = EST_FORMAT_AUTO;
+};
+
+// Decodes the whole source to interleaved f32 at its native rate and channel count.
+// Long sources are split into ranges decoded on their own decoder and thread, straight
+// into their part of frames. threadCount 0 uses every core.
+ma_result DecodeParallel(const EST_DecodeSource &source, unsigned int threadCount, std::vector<float> &frames, ma_uint32 *channels, ma_uint32 *sampleRate);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "SeekIndex.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    constexpr size_t    kOggHeaderSize = 27;
+    constexpr ma_uint64 kSeekIndexSpacing = 24000; // Granules, about half a second at common rates
+    constexpr ma_uint64 kNoGranule = ~0ull;        // Page without a finished packet
+
+    struct EST_OggPage
+    {
+        ma_uint64 granule = kNoGranule;
+        uint32_t  serial = 0;
+        size_t    size = 0; // Header, segment table and body
+    };
+} // namespace
+
+static uint64_t read_le(const unsigned char *data, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | data[i];
+    }
+
+    return value;
+}
+
+// read(offset, buffer, count) fills buffer from the stream, returns false past the end
+template <typename Reader>
+static bool ogg_read_page(Reader &read, size_t offset, EST_OggPage *page)
+{
+    unsigned char header[kOggHeaderSize + 255];
+    if (!read(offset, header, kOggHeaderSize) || std::memcmp(header, "OggS", 4) != 0 || header[4] != 0) {
+        return false;
+    }
+
+    int segments = header[26];
+    if (!read(offset + kOggHeaderSize, header + kOggHeaderSize, segments)) {
+        return false;
+    }
+
+    size_t bodySize = 0;
+    for (int i = 0; i < segments; i++) {
+        bodySize += header[kOggHeaderSize + i];
+    }
+
+    page->granule = read_le(header + 6, 8);
+    page->serial = static_cast<uint32_t>(read_le(header + 14, 4));
+    page->size = kOggHeaderSize + segments + bodySize;
+
+    return true;
+}
+
+template <typename Reader>
+static bool ogg_build_index(Reader &read, std::vector<ma_ogg_seek_point> &points)
+{
+    points.clear();
+
+    EST_OggPage page;
+    if (!ogg_read_page(read, 0, &page)) {
+        return false;
+    }
+
+    uint32_t  serial = page.serial;
+    ma_uint64 previousGranule = 0;
+    size_t    offset = 0;
+
+    while (ogg_read_page(read, offset, &page)) {
+        // Multiplexed or chained streams restart granules, the backends can't use the index
+        if (page.serial != serial) {
+            points.clear();
+            return false;
+        }
+
+        // Decoding from this page never starts before the last finished granule
+        if (previousGranule > 0 && (points.empty() || previousGranule >= points.back().pcmFrame + kSeekIndexSpacing)) {
+            points.push_back({ previousGranule, static_cast<ma_uint64>(offset) });
+        }
+
+        if (page.granule != kNoGranule) {
+            previousGranule = page.granule;
+        }
+
+        offset += page.size;
+    }
+
+    // A truncated or damaged tail still leaves the pages before it usable
+    return !points.empty();
+}
+
+bool BuildOggSeekIndex(const void *data, size_t size, std::vector<ma_ogg_seek_point> &points)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+
+    auto read = [bytes, size](size_t offset, unsigned char *buffer, size_t count) {
+        if (!bytes || offset > size || count > size - offset) {
+            return false;
+        }
+
+        std::memcpy(buffer, bytes + offset, count);
+        return true;
+    };
+
+    try {
+        return ogg_build_index(read, points);
+    } catch (std::bad_alloc &) {
+        points.clear();
+        return false;
+    }
+}
+
+bool BuildOggSeekIndexFile(const char *path, std::vector<ma_ogg_seek_point> &points)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    auto read = [&file](size_t offset, unsigned char *buffer, size_t count) {
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(count));
+
+        if (static_cast<size_t>(file.gcount()) != count) {
+            file.clear();
+            return false;
+        }
+
+        return true;
+    };
+
+    try {
+        return ogg_build_index(read, points);
+    } catch (std::bad_alloc &) {
+        points.clear();
+        return false;
+    }
+}
+
+bool DecoderIsOgg(const ma_decoder *decoder)
+{
+    // The vtables are static per translation unit, compare the backend entry points instead
+    const ma_decoding_backend_vtable *vtable = decoder->pBackendVTable;
+
+    return vtable && (vtable->onInit == ma_decoding_backend_init__libvorbis || vtable->onInit == ma_decoding_backend_init__libopus);
+}
+
+bool DecoderBindSeekIndex(ma_decoder *decoder, const std::vector<ma_ogg_seek_point> &points)
+{
+    if (!DecoderIsOgg(decoder) || points.empty()) {
+        return false;
+    }
+
+    ma_result result;
+    if (decoder->pBackendVTable->onInit == ma_decoding_backend_init__libvorbis) {
+        result = ma_decoding_backend_bind_seek_index__libvorbis(decoder->pBackend, points.data(), static_cast<ma_uint32>(points.size()));
+    } else {
+        result = ma_decoding_backend_bind_seek_index__libopus(decoder->pBackend, points.data(), static_cast<ma_uint32>(points.size()));
+    }
+
+    return result == MA_SUCCESS;
+}
+
+bool DecoderShareSeekTable(const ma_decoder *source, ma_decoder *decoder)
+{
+    return ma_decoder_share_mp3_seek_table(source, decoder) == MA_SUCCESS;
+}
+
+bool DecoderCopySeekTable(const ma_decoder *source, ma_decoder *decoder)
+{
+    return ma_decoder_copy_mp3_seek_table(source, decoder) == MA_SUCCESS;
+}
\ No newline at end of file
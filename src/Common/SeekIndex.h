@@ -0,0 +1,24 @@
+#ifndef __COMMON_SEEK_INDEX_H_
+#define __COMMON_SEEK_INDEX_H_
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+#include <cstddef>
+#include <vector>
+
+// Collects one page offset about every kSeekIndexSpacing granules of a single logical Ogg stream
+// Only page headers are read, nothing is decoded. Returns false for anything but a plain Ogg stream.
+bool BuildOggSeekIndex(const void *data, size_t size, std::vector<ma_ogg_seek_point> &points);
+bool BuildOggSeekIndexFile(const char *path, std::vector<ma_ogg_seek_point> &points);
+
+// True when the decoder runs on one of the Ogg backends and can take a page index
+bool DecoderIsOgg(const ma_decoder *decoder);
+
+// Hands the index to the Ogg backend, points is referenced and must outlive the decoder
+bool DecoderBindSeekIndex(ma_decoder *decoder, const std::vector<ma_ogg_seek_point> &points);
+
+// Hands the MP3 seek table source built at init to decoder, source must outlive it
+// The decoder should be opened with kDecoderSharedSeekTable so it skips building its own
+bool DecoderShareSeekTable(const ma_decoder *source, ma_decoder *decoder);
+bool DecoderCopySeekTable(const ma_decoder *source, ma_decoder *decoder); // Owned by decoder, source may go first
+
+#endif
\ No newline at end of file
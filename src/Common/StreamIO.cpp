@@ -0,0 +1,441 @@
+#include "StreamIO.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
+namespace {
+    constexpr size_t kReadAheadSize = 1024 * 1024; // Bytes buffered in front of the decoder
+    constexpr size_t kReadAheadChunk = 256 * 1024; // Bytes per source read
+    constexpr size_t kReadAheadReady = 64 * 1024;  // Buffered bytes that serve any one mixer block without waiting
+
+    struct EST_StreamDestructor
+    {
+        inline void operator()(EST_StreamIO *stream) const
+        {
+            // The read-ahead thread still reads the source, stop it before closing
+            stream->readAhead.reset();
+
+            if (stream->io.close) {
+                stream->io.close(stream->io.userData);
+            }
+
+            delete stream;
+        }
+    };
+} // namespace
+
+// The ring holds the source bytes [position, position + available), only the thread that owns
+// the decoder consumes it and only the read-ahead thread fills it
+struct EST_ReadAhead
+{
+    std::thread                thread;
+    std::mutex                 mutex;
+    std::condition_variable    signal;
+    std::vector<unsigned char> ring;
+
+    uint64_t position = 0;   // Source offset of the next byte the decoder reads
+    size_t   head = 0;       // Ring index of position
+    size_t   available = 0;  // Bytes buffered from position
+    uint64_t generation = 0; // Bumped by seeks, fills started before are dropped
+    bool     isAtEnd = false;
+    bool     isStopping = false;
+
+    ~EST_ReadAhead()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+
+        signal.notify_all();
+
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+static size_t file_read(void *pUserData, void *pBuffer, size_t size)
+{
+    return std::fread(pBuffer, 1, size, static_cast<std::FILE *>(pUserData));
+}
+
+static int file_seek(void *pUserData, long long offset, enum EST_SEEK_ORIGIN origin)
+{
+    int whence = origin == EST_SEEK_END ? SEEK_END : (origin == EST_SEEK_CUR ? SEEK_CUR : SEEK_SET);
+
+#if defined(_WIN32)
+    return _fseeki64(static_cast<std::FILE *>(pUserData), offset, whence);
+#else
+    return fseeko(static_cast<std::FILE *>(pUserData), static_cast<off_t>(offset), whence);
+#endif
+}
+
+static long long file_tell(void *pUserData)
+{
+#if defined(_WIN32)
+    return _ftelli64(static_cast<std::FILE *>(pUserData));
+#else
+    return static_cast<long long>(ftello(static_cast<std::FILE *>(pUserData)));
+#endif
+}
+
+static void file_close(void *pUserData)
+{
+    std::fclose(static_cast<std::FILE *>(pUserData));
+}
+
+// Asks the kernel to start reading the next window while this one is copied
+static void stream_hint(EST_StreamIO *stream, uint64_t offset, size_t size)
+{
+#if defined(__linux__)
+    if (stream->file) {
+        posix_fadvise(fileno(stream->file), static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+    }
+#else
+    (void)stream;
+    (void)offset;
+    (void)size;
+#endif
+}
+
+static void read_ahead_loop(EST_StreamIO *stream)
+{
+    EST_ReadAhead *ahead = stream->readAhead.get();
+    size_t         capacity = ahead->ring.size();
+    int64_t        sourceCursor = -1;
+
+    std::unique_lock<std::mutex> lock(ahead->mutex);
+
+    while (true) {
+        ahead->signal.wait(lock, [ahead, capacity] {
+            return ahead->isStopping || (!ahead->isAtEnd && ahead->available < capacity);
+        });
+
+        if (ahead->isStopping) {
+            return;
+        }
+
+        uint64_t generation = ahead->generation;
+        uint64_t offset = ahead->position + ahead->available;
+        size_t   tail = (ahead->head + ahead->available) % capacity;
+        size_t   chunk = std::min({ kReadAheadChunk, capacity - ahead->available, capacity - tail });
+
+        // The consumer never touches the free part of the ring, fill it unlocked
+        lock.unlock();
+
+        size_t bytesRead = 0;
+        bool   isFailed = false;
+
+        if (sourceCursor != static_cast<int64_t>(offset)) {
+            isFailed = stream->io.seek(stream->io.userData, static_cast<long long>(offset), EST_SEEK_SET) != 0;
+        }
+
+        if (!isFailed) {
+            stream_hint(stream, offset + chunk, kReadAheadSize);
+            bytesRead = stream->io.read(stream->io.userData, ahead->ring.data() + tail, chunk);
+        }
+
+        sourceCursor = isFailed ? -1 : static_cast<int64_t>(offset + bytesRead);
+
+        lock.lock();
+
+        if (generation != ahead->generation) {
+            continue;
+        }
+
+        ahead->available += bytesRead;
+        ahead->isAtEnd = bytesRead == 0;
+        ahead->signal.notify_all();
+    }
+}
+
+static ma_result read_ahead_read(EST_StreamIO *stream, void *pDst, size_t sizeInBytes, size_t *pBytesRead)
+{
+    EST_ReadAhead *ahead = stream->readAhead.get();
+    size_t         capacity = ahead->ring.size();
+    size_t         total = 0;
+
+    std::unique_lock<std::mutex> lock(ahead->mutex);
+
+    while (total < sizeInBytes) {
+        ahead->signal.wait(lock, [ahead] {
+            return ahead->available > 0 || ahead->isAtEnd;
+        });
+
+        if (ahead->available == 0) {
+            break;
+        }
+
+        size_t bytes = std::min({ sizeInBytes - total, ahead->available, capacity - ahead->head });
+        std::memcpy(static_cast<unsigned char *>(pDst) + total, ahead->ring.data() + ahead->head, bytes);
+
+        ahead->head = (ahead->head + bytes) % capacity;
+        ahead->available -= bytes;
+        ahead->position += bytes;
+        total += bytes;
+
+        ahead->signal.notify_all();
+    }
+
+    *pBytesRead = total;
+    return total == 0 && sizeInBytes > 0 ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result read_ahead_seek(EST_StreamIO *stream, uint64_t target)
+{
+    EST_ReadAhead *ahead = stream->readAhead.get();
+
+    {
+        std::lock_guard<std::mutex> lock(ahead->mutex);
+
+        if (target >= ahead->position && target - ahead->position <= ahead->available) {
+            // Forward inside the buffered bytes, skip over them
+            size_t skip = static_cast<size_t>(target - ahead->position);
+            ahead->head = (ahead->head + skip) % ahead->ring.size();
+            ahead->available -= skip;
+        } else {
+            ahead->generation++;
+            ahead->head = 0;
+            ahead->available = 0;
+            ahead->isAtEnd = false;
+        }
+
+        ahead->position = target;
+    }
+
+    ahead->signal.notify_all();
+    return MA_SUCCESS;
+}
+
+static EST_StreamIO *stream_from_vfs(ma_vfs *pVFS)
+{
+    return reinterpret_cast<EST_StreamIO *>(pVFS);
+}
+
+// Every open hands out the same source rewound, miniaudio reopens it between probes
+static ma_result stream_open(ma_vfs *pVFS, const char *pFilePath, ma_uint32 openMode, ma_vfs_file *pFile)
+{
+    (void)pFilePath;
+
+    if (openMode != MA_OPEN_MODE_READ) {
+        return MA_INVALID_OPERATION;
+    }
+
+    EST_StreamIO *stream = stream_from_vfs(pVFS);
+
+    ma_result result = stream->readAhead
+                           ? read_ahead_seek(stream, 0)
+                           : (stream->io.seek(stream->io.userData, 0, EST_SEEK_SET) == 0 ? MA_SUCCESS : MA_BAD_SEEK);
+
+    *pFile = stream;
+    return result;
+}
+
+static ma_result stream_open_w(ma_vfs *pVFS, const wchar_t *pFilePath, ma_uint32 openMode, ma_vfs_file *pFile)
+{
+    (void)pFilePath;
+    return stream_open(pVFS, nullptr, openMode, pFile);
+}
+
+// The source lives as long as the stream, not the decoder
+static ma_result stream_close(ma_vfs *pVFS, ma_vfs_file file)
+{
+    (void)pVFS;
+    (void)file;
+    return MA_SUCCESS;
+}
+
+static ma_result stream_read(ma_vfs *pVFS, ma_vfs_file file, void *pDst, size_t sizeInBytes, size_t *pBytesRead)
+{
+    (void)file;
+
+    EST_StreamIO *stream = stream_from_vfs(pVFS);
+    if (stream->readAhead) {
+        return read_ahead_read(stream, pDst, sizeInBytes, pBytesRead);
+    }
+
+    *pBytesRead = stream->io.read(stream->io.userData, pDst, sizeInBytes);
+    return *pBytesRead == 0 && sizeInBytes > 0 ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result stream_write(ma_vfs *pVFS, ma_vfs_file file, const void *pSrc, size_t sizeInBytes, size_t *pBytesWritten)
+{
+    (void)pVFS;
+    (void)file;
+    (void)pSrc;
+    (void)sizeInBytes;
+    (void)pBytesWritten;
+    return MA_INVALID_OPERATION;
+}
+
+static ma_result stream_seek(ma_vfs *pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin)
+{
+    (void)file;
+
+    EST_StreamIO *stream = stream_from_vfs(pVFS);
+
+    if (!stream->readAhead) {
+        auto estOrigin = origin == ma_seek_origin_end ? EST_SEEK_END : (origin == ma_seek_origin_current ? EST_SEEK_CUR : EST_SEEK_SET);
+        return stream->io.seek(stream->io.userData, static_cast<long long>(offset), estOrigin) == 0 ? MA_SUCCESS : MA_BAD_SEEK;
+    }
+
+    int64_t target = offset;
+    if (origin == ma_seek_origin_current) {
+        std::lock_guard<std::mutex> lock(stream->readAhead->mutex);
+        target += static_cast<int64_t>(stream->readAhead->position);
+    } else if (origin == ma_seek_origin_end) {
+        if (stream->size < 0) {
+            return MA_BAD_SEEK;
+        }
+
+        target += stream->size;
+    }
+
+    if (target < 0) {
+        return MA_BAD_SEEK;
+    }
+
+    return read_ahead_seek(stream, static_cast<uint64_t>(target));
+}
+
+static ma_result stream_tell(ma_vfs *pVFS, ma_vfs_file file, ma_int64 *pCursor)
+{
+    (void)file;
+
+    EST_StreamIO *stream = stream_from_vfs(pVFS);
+
+    if (stream->readAhead) {
+        std::lock_guard<std::mutex> lock(stream->readAhead->mutex);
+        *pCursor = static_cast<ma_int64>(stream->readAhead->position);
+        return MA_SUCCESS;
+    }
+
+    long long cursor = stream->io.tell(stream->io.userData);
+    if (cursor < 0) {
+        return MA_ERROR;
+    }
+
+    *pCursor = static_cast<ma_int64>(cursor);
+    return MA_SUCCESS;
+}
+
+static ma_result stream_info(ma_vfs *pVFS, ma_vfs_file file, ma_file_info *pInfo)
+{
+    (void)file;
+
+    EST_StreamIO *stream = stream_from_vfs(pVFS);
+    if (stream->size < 0) {
+        return MA_NOT_IMPLEMENTED;
+    }
+
+    pInfo->sizeInBytes = static_cast<ma_uint64>(stream->size);
+    return MA_SUCCESS;
+}
+
+static std::shared_ptr<EST_StreamIO> stream_create(const est_io_callbacks *io, std::FILE *file, int flags)
+{
+    std::shared_ptr<EST_StreamIO> stream;
+
+    try {
+        stream = std::shared_ptr<EST_StreamIO>(new EST_StreamIO, EST_StreamDestructor{});
+    } catch (std::bad_alloc &) {
+        if (io->close) {
+            io->close(io->userData);
+        }
+
+        return nullptr;
+    }
+
+    stream->vfs = {
+        stream_open,
+        stream_open_w,
+        stream_close,
+        stream_read,
+        stream_write,
+        stream_seek,
+        stream_tell,
+        stream_info
+    };
+
+    stream->io = *io;
+    stream->file = file;
+
+    // Size once up front, the read-ahead thread owns the source position afterwards
+    if (io->seek(io->userData, 0, EST_SEEK_END) == 0) {
+        stream->size = io->tell(io->userData);
+    }
+
+    if (io->seek(io->userData, 0, EST_SEEK_SET) != 0) {
+        return nullptr;
+    }
+
+    if (flags & EST_IO_READAHEAD) {
+        try {
+            stream->readAhead = std::make_unique<EST_ReadAhead>();
+            stream->readAhead->ring.resize(kReadAheadSize);
+            stream->readAhead->thread = std::thread(read_ahead_loop, stream.get());
+        } catch (std::exception &) {
+            return nullptr;
+        }
+    }
+
+    return stream;
+}
+
+std::shared_ptr<EST_StreamIO> StreamOpenCallbacks(const est_io_callbacks *io, int flags)
+{
+    if (!io->read || !io->seek || !io->tell) {
+        if (io->close) {
+            io->close(io->userData);
+        }
+
+        return nullptr;
+    }
+
+    return stream_create(io, nullptr, flags);
+}
+
+std::shared_ptr<EST_StreamIO> StreamOpenFile(const char *path, int flags)
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) {
+        return nullptr;
+    }
+
+    // Blocks go straight into the ring or the decoder, stdio buffering would only copy them twice
+    if (flags & EST_IO_READAHEAD) {
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    }
+
+#if defined(__linux__)
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    est_io_callbacks io = {};
+    io.read = file_read;
+    io.seek = file_seek;
+    io.tell = file_tell;
+    io.close = file_close;
+    io.userData = file;
+
+    return stream_create(&io, file, flags);
+}
+
+bool StreamIsReady(EST_StreamIO *stream)
+{
+    EST_ReadAhead *ahead = stream->readAhead.get();
+    if (!ahead) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(ahead->mutex);
+    return ahead->isAtEnd || ahead->available >= std::min(kReadAheadReady, ahead->ring.size());
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __COMMON_STREAM_IO_H_
+#define __COMMON_STREAM_IO_H_
+
+#include <EstTypes.h>
+
+#include "../third-party/miniaudio/miniaudio_decoders.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+struct EST_ReadAhead;
+
+// A byte source the decoder reads through miniaudio's VFS, one open file per stream
+struct EST_StreamIO
+{
+    ma_vfs_callbacks vfs; // Must stay first, miniaudio casts the ma_vfs pointer back to it
+    est_io_callbacks io;  // Where the bytes come from, stdio for streams opened from a path
+    std::FILE       *file = nullptr;
+    int64_t          size = -1; // -1 when the source can't tell
+
+    std::unique_ptr<EST_ReadAhead> readAhead;
+};
+
+// Wraps the caller callbacks, io->close runs when the stream is released even if this fails
+std::shared_ptr<EST_StreamIO> StreamOpenCallbacks(const est_io_callbacks *io, int flags);
+
+// Opens the file with stdio, sequential access is hinted to the kernel where supported
+std::shared_ptr<EST_StreamIO> StreamOpenFile(const char *path, int flags);
+
+// False while the read-ahead ring refills (after a seek or when the source falls behind), a decoder
+// read would wait on the source then. Always true without read-ahead, reads go straight to the source.
+bool StreamIsReady(EST_StreamIO *stream);
+
+inline ma_vfs *StreamGetVFS(EST_StreamIO *stream)
+{
+    return reinterpret_cast<ma_vfs *>(stream);
+}
+
+#endif
\ No newline at end of file
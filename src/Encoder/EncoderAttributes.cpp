@@ -47,6 +47,16 @@ EST_RESULT EST_EncoderSetAttribute(EST_ENCODER_HANDLE handle, enum EST_ATTRIBUTE
             ma_uint32 target = (ma_uint64)(value);
 
             ma_data_converter_set_rate(&decoder->decoder.converter, target, originSample);
+
+            // Both kept copies come from before the rate mod
+            EncoderReleaseSource(decoder);
+            decoder->isStretchedValid = false;
+            break;
+        }
+
+        case EST_ATTRIB_ENCODER_QUALITY:
+        {
+            decoder->exportQuality = std::clamp(value, 0.0f, 1.0f);
             break;
         }
 
@@ -99,6 +109,12 @@ EST_RESULT EST_EncoderGetAttribute(EST_ENCODER_HANDLE handle, enum EST_ATTRIBUTE
             break;
         }
 
+        case EST_ATTRIB_ENCODER_QUALITY:
+        {
+            *value = decoder->exportQuality;
+            break;
+        }
+
         default:
         {
             EST_EncoderSetError("Attrib is not supported or not found!");
@@ -0,0 +1,164 @@
+#include "EncoderInternal.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+static double batch_seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static EST_RESULT batch_apply_attributes(EST_ENCODER_HANDLE handle, const est_encoder_job *job)
+{
+    const struct
+    {
+        int                      field;
+        enum EST_ATTRIBUTE_FLAGS attribute;
+        float                    value;
+    } attributes[] = {
+        { EST_VARIANT_TEMPO, EST_ATTRIB_ENCODER_TEMPO, job->tempo },
+        { EST_VARIANT_PITCH, EST_ATTRIB_ENCODER_PITCH, job->pitch },
+        { EST_VARIANT_SAMPLERATE, EST_ATTRIB_ENCODER_SAMPLERATE, job->sampleRate },
+        { EST_VARIANT_VOLUME, EST_ATTRIB_VOLUME, job->volume },
+        { EST_VARIANT_PAN, EST_ATTRIB_PAN, job->pan },
+    };
+
+    for (const auto &entry : attributes) {
+        if (!(job->fields & entry.field)) {
+            continue;
+        }
+
+        EST_RESULT result = EST_EncoderSetAttribute(handle, entry.attribute, entry.value);
+        if (result != EST_OK) {
+            return result;
+        }
+    }
+
+    return EST_OK;
+}
+
+static EST_RESULT batch_convert(est_encoder_job *job)
+{
+    EST_ENCODER_HANDLE handle = nullptr;
+
+    EST_RESULT result = EST_EncoderLoadWithFormat(job->inputPath, nullptr, job->flags, job->inputFormat, &handle);
+    if (result != EST_OK) {
+        return result;
+    }
+
+    auto encoder = reinterpret_cast<EST_Encoder *>(handle);
+
+    // The pool already keeps every core busy, a parallel decode per job would only oversubscribe
+    encoder->decodeThreads = 1;
+
+    result = batch_apply_attributes(handle, job);
+
+    if (result == EST_OK) {
+        result = EST_EncoderRender(handle);
+    }
+
+    if (result == EST_OK) {
+        job->audioSeconds = static_cast<double>(encoder->numOfPcmProcessed) / static_cast<double>(encoder->decoder.outputSampleRate);
+        result = EST_EncoderExportFile(handle, job->exportType, const_cast<char *>(job->outputPath));
+    }
+
+    EST_EncoderFree(handle);
+
+    return result;
+}
+
+static void batch_run_job(est_encoder_job *job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    EST_EncoderSetError("");
+
+    job->audioSeconds = 0.0;
+    job->result = batch_convert(job);
+    job->seconds = batch_seconds_since(start);
+
+    const char *error = job->result == EST_OK ? "" : EST_EncoderGetError();
+    if (job->result != EST_OK && !*error) {
+        error = "Conversion failed";
+    }
+
+    std::strncpy(job->error, error, sizeof(job->error) - 1);
+    job->error[sizeof(job->error) - 1] = '\0';
+}
+
+EST_RESULT EST_EncoderRunBatch(est_encoder_job *jobs, int jobCount, int threadCount, est_batch_summary *summary)
+{
+    if (!jobs || jobCount < 0 || threadCount < 0) {
+        EST_EncoderSetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (int i = 0; i < jobCount; i++) {
+        if (!jobs[i].inputPath || !jobs[i].outputPath) {
+            EST_EncoderSetError("Job without input or output path");
+            return EST_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    if (jobCount == 0) {
+        if (summary) {
+            *summary = {};
+        }
+
+        return EST_OK;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    unsigned int threads = threadCount > 0 ? static_cast<unsigned int>(threadCount) : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(jobCount)));
+
+    // Workers take the next job until none is left, a slow file never holds up a whole share
+    std::atomic<int> next = { 0 };
+
+    auto worker = [&] {
+        for (int i = next++; i < jobCount; i = next++) {
+            batch_run_job(&jobs[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+
+    try {
+        pool.reserve(threads - 1);
+
+        for (unsigned int i = 1; i < threads; i++) {
+            pool.emplace_back(worker);
+        }
+    } catch (std::exception &) {
+        // Out of threads or memory, the ones running pick up the rest and are still joined below
+    }
+
+    worker();
+
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    if (summary) {
+        *summary = {};
+        summary->jobs = jobCount;
+        summary->seconds = batch_seconds_since(start);
+
+        for (int i = 0; i < jobCount; i++) {
+            if (jobs[i].result != EST_OK) {
+                summary->failed++;
+            } else {
+                summary->audioSeconds += jobs[i].audioSeconds;
+            }
+        }
+
+        if (summary->seconds > 0.0) {
+            summary->filesPerSecond = static_cast<double>(jobCount - summary->failed) / summary->seconds;
+            summary->realtime = summary->audioSeconds / summary->seconds;
+        }
+    }
+
+    return EST_OK;
+}
\ No newline at end of file
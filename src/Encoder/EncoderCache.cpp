@@ -0,0 +1,321 @@
+#include "EncoderInternal.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    constexpr char        kRenderMagic[8] = { 'E', 'S', 'T', 'R', 'N', 'D', '0', '1' };
+    constexpr uint32_t    kRenderVersion = 1; // Bump whenever a change to the render chain changes its output
+    constexpr uint32_t    kStretchPreset = 1; // presetDefault
+    constexpr uint64_t    kFnvOffset = 14695981039346656037ull;
+    constexpr uint64_t    kFnvPrime = 1099511628211ull;
+    constexpr size_t      kHashChunkBytes = 1024 * 1024;
+    constexpr const char *kRenderExtension = ".estrender";
+
+    // Followed by the interleaved f32 frames, 64 bytes keeps them aligned in the mapping
+    struct EST_RenderHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t channels;
+        uint32_t sampleRate;
+        uint32_t reserved;
+        uint64_t frameCount;
+        uint64_t key;
+        uint8_t  padding[24];
+    };
+
+    static_assert(sizeof(EST_RenderHeader) == 64, "render header must keep the frames aligned");
+
+    // Everything besides the source that changes the rendered frames
+    struct EST_RenderParams
+    {
+        uint32_t version;
+        uint32_t preset;
+        uint32_t channels;
+        uint32_t outputRate;
+        float    rate;
+        float    pitch;
+        float    sampleRate;
+        float    volume;
+        float    pan;
+        uint32_t isParallel;
+    };
+
+    std::mutex  gCacheLock;
+    std::string gCacheDirectory; // Empty when disabled
+    uint64_t    gCacheBudget = 0;
+} // namespace
+
+static uint64_t cache_hash(uint64_t hash, const void *data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+
+    return hash;
+}
+
+// Whole source content, two copies of a song hit the same entries wherever they live
+static bool cache_source_hash(EST_Encoder *encoder, uint64_t *hash)
+{
+    if (encoder->isSourceHashed) {
+        *hash = encoder->sourceHash;
+        return true;
+    }
+
+    uint64_t value = kFnvOffset;
+
+    if (encoder->sourceData) {
+        value = cache_hash(value, encoder->sourceData, encoder->sourceSize);
+    } else if (!encoder->sourcePath.empty()) {
+        std::ifstream file(encoder->sourcePath, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        std::vector<char> buffer(kHashChunkBytes);
+        while (file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            value = cache_hash(value, buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+    } else {
+        return false;
+    }
+
+    encoder->sourceHash = value;
+    encoder->isSourceHashed = true;
+    *hash = value;
+
+    return true;
+}
+
+static bool cache_key(EST_Encoder *encoder, bool isParallel, uint64_t *key)
+{
+    uint64_t source = 0;
+    if (!cache_source_hash(encoder, &source)) {
+        return false;
+    }
+
+    EST_RenderParams params = {};
+    params.version = kRenderVersion;
+    params.preset = kStretchPreset;
+    params.channels = static_cast<uint32_t>(encoder->channels);
+    params.outputRate = encoder->decoder.outputSampleRate;
+    params.rate = encoder->rate;
+    params.pitch = encoder->pitch;
+    params.sampleRate = encoder->sampleRate;
+    params.pan = ma_panner_get_pan(&encoder->panner);
+    params.isParallel = isParallel ? 1 : 0;
+    ma_gainer_get_master_volume(&encoder->gainer, &params.volume);
+
+    // Unchanged tempo and pitch skip the stretcher, both modes render the same frames then
+    if (params.rate == 1.0f && params.pitch == 1.0f) {
+        params.isParallel = 0;
+    }
+
+    *key = cache_hash(cache_hash(kFnvOffset, &source, sizeof(source)), &params, sizeof(params));
+    return true;
+}
+
+static std::filesystem::path cache_path(const std::string &directory, uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+    return std::filesystem::path(directory) / (std::string(name) + kRenderExtension);
+}
+
+// The callback sees (and may change) every chunk, only renders without one are cached
+static bool cache_settings(EST_Encoder *encoder, std::string *directory, uint64_t *budget)
+{
+    if (encoder->callback) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gCacheLock);
+    *directory = gCacheDirectory;
+    *budget = gCacheBudget;
+
+    return !directory->empty();
+}
+
+// Least recently used entries go first, a hit refreshes the modification time
+static void cache_evict(const std::string &directory, uint64_t budget)
+{
+    struct EST_RenderEntry
+    {
+        std::filesystem::path           path;
+        std::filesystem::file_time_type time;
+        uint64_t                        size;
+    };
+
+    std::error_code              error;
+    std::vector<EST_RenderEntry> entries;
+    uint64_t                     total = 0;
+
+    for (const auto &item : std::filesystem::directory_iterator(directory, error)) {
+        if (item.path().extension() != kRenderExtension) {
+            continue;
+        }
+
+        EST_RenderEntry entry;
+        entry.path = item.path();
+        entry.time = item.last_write_time(error);
+        entry.size = item.file_size(error);
+
+        if (!error) {
+            total += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    if (total <= budget) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const EST_RenderEntry &a, const EST_RenderEntry &b) {
+        return a.time < b.time;
+    });
+
+    for (const auto &entry : entries) {
+        if (total <= budget) {
+            break;
+        }
+
+        // Mapped entries stay readable after removal on POSIX, Windows refuses and keeps them
+        if (std::filesystem::remove(entry.path, error)) {
+            total -= entry.size;
+        }
+    }
+}
+
+bool EncoderCacheLookup(EST_Encoder *encoder, bool isParallel)
+{
+    std::string directory;
+    uint64_t    budget = 0;
+    uint64_t    key = 0;
+
+    try {
+        if (!cache_settings(encoder, &directory, &budget) || !cache_key(encoder, isParallel, &key)) {
+            return false;
+        }
+
+        auto path = cache_path(directory, key);
+
+        std::error_code error;
+        if (!std::filesystem::exists(path, error)) {
+            return false;
+        }
+
+        const char *mapError = nullptr;
+        auto        mapping = MapFile(path.string().c_str(), EST_MAP_SEQUENTIAL, &mapError);
+        if (!mapping || mapping->size < sizeof(EST_RenderHeader)) {
+            return false;
+        }
+
+        EST_RenderHeader header;
+        std::memcpy(&header, mapping->data, sizeof(header));
+
+        bool isValid = std::memcmp(header.magic, kRenderMagic, sizeof(kRenderMagic)) == 0 &&
+                       header.version == kRenderVersion &&
+                       header.key == key &&
+                       header.channels == static_cast<uint32_t>(encoder->channels) &&
+                       header.frameCount > 0 &&
+                       header.frameCount <= static_cast<uint64_t>(INT32_MAX) &&
+                       header.frameCount <= (mapping->size - sizeof(header)) / (sizeof(float) * header.channels);
+
+        if (!isValid) {
+            return false;
+        }
+
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+        std::vector<float>().swap(encoder->data);
+        encoder->mapped = mapping;
+        encoder->mappedFrames = reinterpret_cast<const float *>(mapping->data + sizeof(header));
+        encoder->numOfPcmProcessed = static_cast<int>(header.frameCount);
+    } catch (std::exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+void EncoderCacheStore(EST_Encoder *encoder, bool isParallel)
+{
+    std::string directory;
+    uint64_t    budget = 0;
+    uint64_t    key = 0;
+
+    if (encoder->numOfPcmProcessed <= 0 || encoder->data.empty()) {
+        return;
+    }
+
+    // A failed write only costs the next render its work, never fail the render over it
+    try {
+        if (!cache_settings(encoder, &directory, &budget) || !cache_key(encoder, isParallel, &key)) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        EST_RenderHeader header = {};
+        std::memcpy(header.magic, kRenderMagic, sizeof(kRenderMagic));
+        header.version = kRenderVersion;
+        header.channels = static_cast<uint32_t>(encoder->channels);
+        header.sampleRate = encoder->decoder.outputSampleRate;
+        header.frameCount = static_cast<uint64_t>(encoder->numOfPcmProcessed);
+        header.key = key;
+
+        auto target = cache_path(directory, key);
+        auto temporary = target;
+        temporary += ".tmp";
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(encoder->data.data()), static_cast<std::streamsize>(header.frameCount * header.channels * sizeof(float)));
+
+            if (!file) {
+                file.close();
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+
+        // Readers only ever see a complete file
+        std::filesystem::rename(temporary, target, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+
+        if (budget > 0) {
+            cache_evict(directory, budget);
+        }
+    } catch (std::exception &) {
+    }
+}
+
+EST_RESULT EST_EncoderSetRenderCache(const char *directory, long long maxBytes)
+{
+    if (maxBytes < 0) {
+        EST_EncoderSetError("Invalid cache size");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(gCacheLock);
+        gCacheDirectory = directory ? directory : "";
+        gCacheBudget = static_cast<uint64_t>(maxBytes);
+    } catch (std::bad_alloc &alloc) {
+        EST_EncoderSetError(alloc.what());
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    return EST_OK;
+}
\ No newline at end of file
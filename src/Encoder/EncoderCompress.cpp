@@ -0,0 +1,462 @@
+#include "EncoderInternal.h"
+#include <chrono>
+#include <cstring>
+#include <ogg/ogg.h>
+#include <opus/opus.h>
+#include <vorbis/vorbisenc.h>
+
+namespace {
+    constexpr int        kVorbisBlockFrames = 1024; // Frames handed to the Vorbis analysis at once
+    constexpr int        kOpusGranuleRate = 48000;  // Opus granule positions always count 48 kHz samples
+    constexpr opus_int32 kOpusMaxPacket = 4000;
+
+    // Source channel of each Vorbis channel, frames come in WAV order (FL FR FC LFE BL BR SL SR) and
+    // Vorbis defines its own up to 8 channels (5.1 is FL FC FR RL RR LFE). Past 8 the order is left as is.
+    constexpr int kVorbisChannelOrder[8][8] = {
+        { 0 },
+        { 0, 1 },
+        { 0, 2, 1 },
+        { 0, 1, 2, 3 },
+        { 0, 2, 1, 3, 4 },
+        { 0, 2, 1, 4, 5, 3 },
+        { 0, 2, 1, 5, 6, 4, 3 },
+        { 0, 2, 1, 6, 7, 4, 5, 3 },
+    };
+} // namespace
+
+struct EST_CompressedWriter
+{
+    enum EST_FILE_EXPORT type = EST_EXPORT_UNKNOWN;
+    est_export_callbacks output = {};
+    int                  channels = 0;
+    int                  sampleRate = 0;
+    bool                 isFailed = false;
+
+    ogg_stream_state stream = {};
+    bool             isStreamInit = false;
+
+    vorbis_info      vorbisInfo = {};
+    vorbis_comment   vorbisComment = {};
+    vorbis_dsp_state vorbisDsp = {};
+    vorbis_block     vorbisBlock = {};
+    bool             isVorbisInit = false;
+
+    // Opus takes 20 ms frames at a few rates only, anything else is resampled to 48 kHz first
+    OpusEncoder               *opus = nullptr;
+    int                        opusRate = 0;
+    int                        frameSize = 0;
+    int                        preSkip = 0; // 48 kHz samples of encoder lookahead the player drops
+    ma_resampler               resampler = {};
+    bool                       isResampling = false;
+    std::vector<float>         pending; // Frames short of a whole Opus frame
+    std::vector<float>         resampled;
+    std::vector<unsigned char> packet;
+    ma_uint64                  sourceFrames = 0; // Frames written, at sampleRate
+    ogg_int64_t                granule = 0;
+    ogg_int64_t                packetNo = 0;
+};
+
+static bool ogg_write_pages(EST_CompressedWriter *writer, bool flush)
+{
+    ogg_page page;
+
+    while (flush ? ogg_stream_flush(&writer->stream, &page) : ogg_stream_pageout(&writer->stream, &page)) {
+        if (writer->output.write(writer->output.userData, page.header, page.header_len) != static_cast<size_t>(page.header_len) ||
+            writer->output.write(writer->output.userData, page.body, page.body_len) != static_cast<size_t>(page.body_len)) {
+            writer->isFailed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void write_le16(unsigned char *dst, unsigned int value)
+{
+    dst[0] = static_cast<unsigned char>(value);
+    dst[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void write_le32(unsigned char *dst, unsigned int value)
+{
+    write_le16(dst, value & 0xFFFF);
+    write_le16(dst + 2, value >> 16);
+}
+
+// Pulls every packet the analysis has ready into the stream
+static bool vorbis_drain(EST_CompressedWriter *writer)
+{
+    ogg_packet packet;
+
+    while (vorbis_analysis_blockout(&writer->vorbisDsp, &writer->vorbisBlock) == 1) {
+        vorbis_analysis(&writer->vorbisBlock, nullptr);
+        vorbis_bitrate_addblock(&writer->vorbisBlock);
+
+        while (vorbis_bitrate_flushpacket(&writer->vorbisDsp, &packet)) {
+            ogg_stream_packetin(&writer->stream, &packet);
+
+            if (!ogg_write_pages(writer, false)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool vorbis_open(EST_CompressedWriter *writer, float quality, const char **error)
+{
+    vorbis_info_init(&writer->vorbisInfo);
+    vorbis_comment_init(&writer->vorbisComment);
+
+    // Vorbis quality runs from -0.1 to 1
+    if (vorbis_encode_init_vbr(&writer->vorbisInfo, writer->channels, writer->sampleRate, -0.1f + quality * 1.1f) != 0) {
+        vorbis_comment_clear(&writer->vorbisComment);
+        vorbis_info_clear(&writer->vorbisInfo);
+        *error = "Vorbis doesn't support this channel count or sample rate";
+        return false;
+    }
+
+    vorbis_comment_add_tag(&writer->vorbisComment, "ENCODER", "EstAudio");
+    vorbis_analysis_init(&writer->vorbisDsp, &writer->vorbisInfo);
+    vorbis_block_init(&writer->vorbisDsp, &writer->vorbisBlock);
+    writer->isVorbisInit = true;
+
+    ogg_packet header;
+    ogg_packet comment;
+    ogg_packet codebook;
+
+    vorbis_analysis_headerout(&writer->vorbisDsp, &writer->vorbisComment, &header, &comment, &codebook);
+    ogg_stream_packetin(&writer->stream, &header);
+    ogg_stream_packetin(&writer->stream, &comment);
+    ogg_stream_packetin(&writer->stream, &codebook);
+
+    // Audio has to start on a page of its own
+    if (!ogg_write_pages(writer, true)) {
+        *error = "Failed to write export data";
+        return false;
+    }
+
+    return true;
+}
+
+static bool vorbis_write(EST_CompressedWriter *writer, const float *frames, ma_uint64 frameCount)
+{
+    for (ma_uint64 offset = 0; offset < frameCount; offset += kVorbisBlockFrames) {
+        int          count = static_cast<int>(std::min<ma_uint64>(kVorbisBlockFrames, frameCount - offset));
+        float      **buffer = vorbis_analysis_buffer(&writer->vorbisDsp, count);
+        const float *block = frames + offset * writer->channels;
+
+        for (int channel = 0; channel < writer->channels; channel++) {
+            int source = writer->channels <= 8 ? kVorbisChannelOrder[writer->channels - 1][channel] : channel;
+
+            for (int i = 0; i < count; i++) {
+                buffer[channel][i] = block[i * writer->channels + source];
+            }
+        }
+
+        vorbis_analysis_wrote(&writer->vorbisDsp, count);
+
+        if (!vorbis_drain(writer)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool opus_packet_out(EST_CompressedWriter *writer, const float *frame, bool isLast, ogg_int64_t lastGranule)
+{
+    opus_int32 bytes = opus_encode_float(writer->opus, frame, writer->frameSize, writer->packet.data(), kOpusMaxPacket);
+    if (bytes < 0) {
+        writer->isFailed = true;
+        return false;
+    }
+
+    writer->granule += writer->frameSize * (kOpusGranuleRate / writer->opusRate);
+
+    ogg_packet packet = {};
+    packet.packet = writer->packet.data();
+    packet.bytes = bytes;
+    packet.e_o_s = isLast ? 1 : 0;
+    packet.granulepos = isLast ? lastGranule : writer->granule;
+    packet.packetno = writer->packetNo++;
+
+    ogg_stream_packetin(&writer->stream, &packet);
+
+    return ogg_write_pages(writer, isLast);
+}
+
+// Encodes every whole frame of pending and keeps the remainder
+static bool opus_encode_pending(EST_CompressedWriter *writer)
+{
+    size_t frameSamples = static_cast<size_t>(writer->frameSize) * writer->channels;
+    size_t cursor = 0;
+
+    for (; cursor + frameSamples <= writer->pending.size(); cursor += frameSamples) {
+        if (!opus_packet_out(writer, &writer->pending[cursor], false, 0)) {
+            return false;
+        }
+    }
+
+    writer->pending.erase(writer->pending.begin(), writer->pending.begin() + cursor);
+
+    return true;
+}
+
+static bool opus_append(EST_CompressedWriter *writer, const float *frames, ma_uint64 frameCount)
+{
+    if (!writer->isResampling) {
+        writer->pending.insert(writer->pending.end(), frames, frames + frameCount * writer->channels);
+        return true;
+    }
+
+    ma_uint64 expected = 0;
+    ma_resampler_get_expected_output_frame_count(&writer->resampler, frameCount, &expected);
+    writer->resampled.resize(static_cast<size_t>(expected + 1) * writer->channels);
+
+    ma_uint64 frameCountIn = frameCount;
+    ma_uint64 frameCountOut = expected + 1;
+
+    if (ma_resampler_process_pcm_frames(&writer->resampler, frames, &frameCountIn, writer->resampled.data(), &frameCountOut) != MA_SUCCESS) {
+        writer->isFailed = true;
+        return false;
+    }
+
+    writer->pending.insert(writer->pending.end(), writer->resampled.begin(), writer->resampled.begin() + frameCountOut * writer->channels);
+
+    return true;
+}
+
+static bool opus_open(EST_CompressedWriter *writer, float quality, const char **error)
+{
+    if (writer->channels > 2) {
+        *error = "Opus export supports mono and stereo only";
+        return false;
+    }
+
+    switch (writer->sampleRate) {
+        case 8000:
+        case 12000:
+        case 16000:
+        case 24000:
+        case 48000:
+            writer->opusRate = writer->sampleRate;
+            break;
+        default:
+        {
+            ma_resampler_config config = ma_resampler_config_init(
+                ma_format_f32,
+                writer->channels,
+                writer->sampleRate,
+                kOpusGranuleRate,
+                ma_resample_algorithm_linear);
+
+            if (ma_resampler_init(&config, nullptr, &writer->resampler) != MA_SUCCESS) {
+                *error = "Failed to create the Opus resampler";
+                return false;
+            }
+
+            writer->isResampling = true;
+            writer->opusRate = kOpusGranuleRate;
+            break;
+        }
+    }
+
+    int result = OPUS_OK;
+
+    writer->opus = opus_encoder_create(writer->opusRate, writer->channels, OPUS_APPLICATION_AUDIO, &result);
+    if (result != OPUS_OK || !writer->opus) {
+        *error = "Failed to create the Opus encoder";
+        return false;
+    }
+
+    // 16 to 128 kbps per channel
+    opus_encoder_ctl(writer->opus, OPUS_SET_BITRATE(static_cast<opus_int32>((16000 + quality * 112000) * writer->channels)));
+
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(writer->opus, OPUS_GET_LOOKAHEAD(&lookahead));
+
+    writer->frameSize = writer->opusRate / 50;
+    writer->preSkip = lookahead * (kOpusGranuleRate / writer->opusRate);
+    writer->granule = 0;
+    writer->packet.resize(kOpusMaxPacket);
+
+    // RFC 7845 identification and comment headers, each on a page of its own
+    unsigned char head[19] = { 'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1 };
+    head[9] = static_cast<unsigned char>(writer->channels);
+    write_le16(head + 10, static_cast<unsigned int>(writer->preSkip));
+    write_le32(head + 12, static_cast<unsigned int>(writer->sampleRate));
+
+    const char    vendor[] = "EstAudio";
+    unsigned char tags[8 + 4 + sizeof(vendor) - 1 + 4] = { 'O', 'p', 'u', 's', 'T', 'a', 'g', 's' };
+    write_le32(tags + 8, sizeof(vendor) - 1);
+    std::memcpy(tags + 12, vendor, sizeof(vendor) - 1);
+    write_le32(tags + 12 + sizeof(vendor) - 1, 0);
+
+    ogg_packet packet = {};
+    packet.packet = head;
+    packet.bytes = sizeof(head);
+    packet.b_o_s = 1;
+    packet.packetno = writer->packetNo++;
+    ogg_stream_packetin(&writer->stream, &packet);
+
+    if (!ogg_write_pages(writer, true)) {
+        *error = "Failed to write export data";
+        return false;
+    }
+
+    packet = {};
+    packet.packet = tags;
+    packet.bytes = sizeof(tags);
+    packet.packetno = writer->packetNo++;
+    ogg_stream_packetin(&writer->stream, &packet);
+
+    if (!ogg_write_pages(writer, true)) {
+        *error = "Failed to write export data";
+        return false;
+    }
+
+    return true;
+}
+
+static bool opus_finish(EST_CompressedWriter *writer)
+{
+    // Push what the resampler still holds out with silence
+    if (writer->isResampling) {
+        std::vector<float> silence(static_cast<size_t>(ma_resampler_get_input_latency(&writer->resampler) + 1) * writer->channels);
+
+        if (!opus_append(writer, silence.data(), silence.size() / writer->channels)) {
+            return false;
+        }
+    }
+
+    if (!opus_encode_pending(writer)) {
+        return false;
+    }
+
+    // Only the source frames count towards the end of the stream, not the padding
+    ogg_int64_t endGranule = writer->preSkip + static_cast<ogg_int64_t>(writer->sourceFrames * kOpusGranuleRate / writer->sampleRate);
+
+    // The encoder lags by its lookahead, silence frames follow until the last real sample is out
+    std::vector<float> frame(static_cast<size_t>(writer->frameSize) * writer->channels, 0.0f);
+    std::copy(writer->pending.begin(), writer->pending.end(), frame.begin());
+    writer->pending.clear();
+
+    while (true) {
+        bool isLast = writer->granule + writer->frameSize * (kOpusGranuleRate / writer->opusRate) >= endGranule;
+
+        if (!opus_packet_out(writer, frame.data(), isLast, endGranule)) {
+            return false;
+        }
+
+        if (isLast) {
+            return true;
+        }
+
+        std::fill(frame.begin(), frame.end(), 0.0f);
+    }
+}
+
+static void compressed_free(EST_CompressedWriter *writer)
+{
+    if (writer->isVorbisInit) {
+        vorbis_block_clear(&writer->vorbisBlock);
+        vorbis_dsp_clear(&writer->vorbisDsp);
+        vorbis_comment_clear(&writer->vorbisComment);
+        vorbis_info_clear(&writer->vorbisInfo);
+    }
+
+    if (writer->opus) {
+        opus_encoder_destroy(writer->opus);
+    }
+
+    if (writer->isResampling) {
+        ma_resampler_uninit(&writer->resampler, nullptr);
+    }
+
+    if (writer->isStreamInit) {
+        ogg_stream_clear(&writer->stream);
+    }
+
+    delete writer;
+}
+
+bool IsCompressedExport(enum EST_FILE_EXPORT type)
+{
+    return type == EST_EXPORT_OGG_VORBIS || type == EST_EXPORT_OGG_OPUS;
+}
+
+EST_CompressedWriter *CompressedOpen(enum EST_FILE_EXPORT type, const est_export_callbacks *output, int channels, int sampleRate, float quality, const char **error)
+{
+    EST_CompressedWriter *writer = new (std::nothrow) EST_CompressedWriter;
+    if (!writer) {
+        *error = "Out of memory!";
+        return nullptr;
+    }
+
+    writer->type = type;
+    writer->output = *output;
+    writer->channels = channels;
+    writer->sampleRate = sampleRate;
+
+    // Chained streams need distinct serials, the clock is good enough for one file
+    int serial = static_cast<int>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    ogg_stream_init(&writer->stream, serial);
+    writer->isStreamInit = true;
+
+    bool isOpen = false;
+
+    try {
+        isOpen = type == EST_EXPORT_OGG_OPUS ? opus_open(writer, std::clamp(quality, 0.0f, 1.0f), error) : vorbis_open(writer, std::clamp(quality, 0.0f, 1.0f), error);
+    } catch (std::bad_alloc &) {
+        *error = "Out of memory!";
+    }
+
+    if (!isOpen) {
+        compressed_free(writer);
+        return nullptr;
+    }
+
+    return writer;
+}
+
+bool CompressedWrite(EST_CompressedWriter *writer, const float *frames, ma_uint64 frameCount)
+{
+    if (writer->isFailed) {
+        return false;
+    }
+
+    try {
+        if (writer->type == EST_EXPORT_OGG_OPUS) {
+            writer->sourceFrames += frameCount;
+            return opus_append(writer, frames, frameCount) && opus_encode_pending(writer);
+        }
+
+        return vorbis_write(writer, frames, frameCount);
+    } catch (std::bad_alloc &) {
+        writer->isFailed = true;
+        return false;
+    }
+}
+
+bool CompressedClose(EST_CompressedWriter *writer)
+{
+    bool isWritten = !writer->isFailed;
+
+    try {
+        if (isWritten && writer->type == EST_EXPORT_OGG_OPUS) {
+            isWritten = opus_finish(writer);
+        } else if (isWritten) {
+            // An empty write marks the end of the stream
+            vorbis_analysis_wrote(&writer->vorbisDsp, 0);
+            isWritten = vorbis_drain(writer) && ogg_write_pages(writer, true);
+        }
+    } catch (std::bad_alloc &) {
+        isWritten = false;
+    }
+    compressed_free(writer);
+
+    return isWritten;
+}
\ No newline at end of file
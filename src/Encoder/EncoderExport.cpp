@@ -1,54 +1,519 @@
 #include "EncoderInternal.h"
+#include "../Common/PackedPCM.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 
-EST_RESULT EST_EncoderExportFile(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, char *filePath)
+namespace {
+    constexpr int kExportBlockFrames = 4096;
+    constexpr int kPipelineBlocks = 4; // Blocks in flight between the render and the compressor
+
+    // One WAV being written, blocks go through scratch on their way to the encoder
+    struct EST_ExportWriter
+    {
+        ma_encoder                 encoder;
+        ma_format                  format = ma_format_s16;
+        int                        channels = 0;
+        EST_Dither                 dither;
+        bool                       isDithered = false;
+        std::vector<unsigned char> scratch;
+    };
+
+    // A streamed compressed export renders on the caller thread and compresses on this one
+    struct EST_ExportPipeline
+    {
+        EST_CompressedWriter *writer = nullptr;
+        int                   channels = 0;
+
+        std::mutex                      lock;
+        std::condition_variable         signal;
+        std::deque<std::vector<float>>  filled; // Rendered, waiting for the compressor
+        std::vector<std::vector<float>> spare;  // Compressed, ready to render into again
+        bool                            isClosed = false;
+        bool                            isFailed = false;
+    };
+
+    // Growable buffer behind EST_EncoderExportMemory, WAV seeks back to patch its header
+    struct EST_MemoryOutput
+    {
+        unsigned char *data = nullptr;
+        size_t         size = 0;
+        size_t         capacity = 0;
+        size_t         position = 0;
+    };
+} // namespace
+
+static size_t file_write(void *pUserData, const void *pData, size_t size)
 {
-    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
-    if (!decoder || decoder->Signature != kESTEncoderSignature) {
-        EST_EncoderSetError("Invalid handle");
-        return EST_ERROR_INVALID_ARGUMENT;
+    return std::fwrite(pData, 1, size, static_cast<std::FILE *>(pUserData));
+}
+
+static int file_seek(void *pUserData, long long offset, enum EST_SEEK_ORIGIN origin)
+{
+    int whence = origin == EST_SEEK_END ? SEEK_END : (origin == EST_SEEK_CUR ? SEEK_CUR : SEEK_SET);
+
+#if defined(_WIN32)
+    return _fseeki64(static_cast<std::FILE *>(pUserData), offset, whence);
+#else
+    return fseeko(static_cast<std::FILE *>(pUserData), static_cast<off_t>(offset), whence);
+#endif
+}
+
+static size_t memory_write(void *pUserData, const void *pData, size_t size)
+{
+    auto   memory = static_cast<EST_MemoryOutput *>(pUserData);
+    size_t end = memory->position + size;
+
+    // Doubling keeps a long export to a few reallocations
+    if (end > memory->capacity) {
+        size_t capacity = std::max<size_t>({ end, memory->capacity * 2, 64 * 1024 });
+        auto   data = static_cast<unsigned char *>(std::realloc(memory->data, capacity));
+        if (!data) {
+            return 0;
+        }
+
+        memory->data = data;
+        memory->capacity = capacity;
     }
 
-    if (!decoder->data.size()) {
-        EST_EncoderSetError("Decoder not renderer");
-        return EST_ERROR_ENCODER_EMPTY;
+    std::memcpy(memory->data + memory->position, pData, size);
+    memory->position = end;
+    memory->size = std::max(memory->size, end);
+
+    return size;
+}
+
+static int memory_seek(void *pUserData, long long offset, enum EST_SEEK_ORIGIN origin)
+{
+    auto      memory = static_cast<EST_MemoryOutput *>(pUserData);
+    long long base = origin == EST_SEEK_END ? static_cast<long long>(memory->size) : (origin == EST_SEEK_CUR ? static_cast<long long>(memory->position) : 0);
+
+    if (base + offset < 0 || base + offset > static_cast<long long>(memory->size)) {
+        return -1;
     }
 
-    if (type == EST_EXPORT_WAV) {
-        ma_encoder_config config = ma_encoder_config_init(
-            ma_encoding_format_wav,
-            ma_format_s16,
-            decoder->channels,
-            decoder->decoder.outputSampleRate);
+    memory->position = static_cast<size_t>(base + offset);
+    return 0;
+}
 
-        ma_encoder encoder;
-        ma_result  result = ma_encoder_init_file(filePath, &config, &encoder);
-        if (result != MA_SUCCESS) {
-            return EST_ERROR_INVALID_ARGUMENT;
-        }
+static ma_result output_write(ma_encoder *encoder, const void *pBufferIn, size_t bytesToWrite, size_t *pBytesWritten)
+{
+    auto output = static_cast<const est_export_callbacks *>(encoder->pUserData);
+
+    *pBytesWritten = output->write(output->userData, pBufferIn, bytesToWrite);
+    return *pBytesWritten == bytesToWrite ? MA_SUCCESS : MA_IO_ERROR;
+}
+
+static ma_result output_seek(ma_encoder *encoder, ma_int64 offset, ma_seek_origin origin)
+{
+    auto                 output = static_cast<const est_export_callbacks *>(encoder->pUserData);
+    enum EST_SEEK_ORIGIN whence = origin == ma_seek_origin_end ? EST_SEEK_END : (origin == ma_seek_origin_current ? EST_SEEK_CUR : EST_SEEK_SET);
 
-        int dataSize = decoder->numOfPcmProcessed * decoder->channels;
+    return output->seek(output->userData, offset, whence) == 0 ? MA_SUCCESS : MA_IO_ERROR;
+}
+
+static bool export_format(enum EST_FILE_EXPORT type, ma_format *format)
+{
+    switch (type) {
+        case EST_EXPORT_WAV:
+            *format = ma_format_s16;
+            return true;
+        case EST_EXPORT_WAV_S24:
+            *format = ma_format_s24;
+            return true;
+        case EST_EXPORT_WAV_S32:
+            *format = ma_format_s32;
+            return true;
+        case EST_EXPORT_WAV_F32:
+            *format = ma_format_f32;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool export_write(EST_ExportWriter *writer, const float *frames, ma_uint64 frameCount)
+{
+    for (ma_uint64 offset = 0; offset < frameCount; offset += kExportBlockFrames) {
+        ma_uint64    count = std::min<ma_uint64>(kExportBlockFrames, frameCount - offset);
+        const float *block = frames + offset * writer->channels;
+        const void  *data = block;
 
-        // Convert data to signed int16
-        std::vector<int16_t> data(dataSize);
-        for (int i = 0; i < dataSize; i++) {
-            float f = decoder->data[i];
-            f = std::clamp(f * 32768.0f, -32768.0f, 32767.0f);
+        if (writer->format != ma_format_f32) {
+            int bits = static_cast<int>(ma_get_bytes_per_sample(writer->format)) * 8;
 
-            int16_t val = static_cast<int16_t>(f);
-            data[i] = val;
+            QuantizeSamples(block, writer->scratch.data(), static_cast<size_t>(count * writer->channels), bits, writer->isDithered ? &writer->dither : nullptr);
+            data = writer->scratch.data();
         }
 
         ma_uint64 written = 0;
-        result = ma_encoder_write_pcm_frames(&encoder, &data[0], decoder->numOfPcmProcessed, &written);
-        if (result != MA_SUCCESS) {
-            return EST_ERROR_ENCODER_INVALID_WRITE;
+        if (ma_encoder_write_pcm_frames(&writer->encoder, data, count, &written) != MA_SUCCESS || written != count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void pipeline_loop(EST_ExportPipeline *pipeline)
+{
+    while (true) {
+        std::vector<float> block;
+
+        {
+            std::unique_lock<std::mutex> lock(pipeline->lock);
+            pipeline->signal.wait(lock, [pipeline] {
+                return pipeline->isClosed || !pipeline->filled.empty();
+            });
+
+            if (pipeline->filled.empty()) {
+                return;
+            }
+
+            block = std::move(pipeline->filled.front());
+            pipeline->filled.pop_front();
+        }
+
+        bool isWritten = CompressedWrite(pipeline->writer, block.data(), block.size() / pipeline->channels);
+
+        {
+            std::lock_guard<std::mutex> lock(pipeline->lock);
+            pipeline->isFailed = pipeline->isFailed || !isWritten;
+            pipeline->spare.push_back(std::move(block));
         }
 
-        ma_encoder_uninit(&encoder);
+        pipeline->signal.notify_all();
+    }
+}
+
+// Renders block by block while the previous blocks compress, the two only wait on each other when one falls behind
+static EST_RESULT export_pipeline_stream(EST_ExportPipeline *pipeline, EST_ENCODER_HANDLE handle)
+{
+    std::thread thread;
+
+    try {
+        thread = std::thread(pipeline_loop, pipeline);
+    } catch (std::exception &) {
+        // No thread (or memory for one) to spare, compress each block right after rendering it
+    }
+
+    EST_RESULT result = EST_EncoderResetStream(handle);
+
+    while (result == EST_OK) {
+        std::vector<float> block;
+
+        {
+            std::unique_lock<std::mutex> lock(pipeline->lock);
+            pipeline->signal.wait(lock, [pipeline] {
+                return pipeline->isFailed || !pipeline->spare.empty();
+            });
+
+            if (pipeline->isFailed) {
+                break;
+            }
+
+            block = std::move(pipeline->spare.back());
+            pipeline->spare.pop_back();
+        }
+
+        // Within the reserved capacity, no allocation
+        block.resize(static_cast<size_t>(kExportBlockFrames) * pipeline->channels);
+
+        int framesRead = 0;
+
+        result = EST_EncoderReadFrames(handle, block.data(), kExportBlockFrames, &framesRead);
+        if (result != EST_OK || framesRead == 0) {
+            break;
+        }
+
+        block.resize(static_cast<size_t>(framesRead) * pipeline->channels);
+
+        if (!thread.joinable()) {
+            pipeline->isFailed = !CompressedWrite(pipeline->writer, block.data(), static_cast<ma_uint64>(framesRead));
+            pipeline->spare.push_back(std::move(block));
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pipeline->lock);
+            pipeline->filled.push_back(std::move(block));
+        }
+
+        pipeline->signal.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pipeline->lock);
+        pipeline->isClosed = true;
+    }
+
+    pipeline->signal.notify_all();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    EST_EncoderResetStream(handle);
+
+    return result;
+}
+
+static EST_RESULT export_compressed(EST_Encoder *decoder, EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, bool isStream, const est_export_callbacks *output)
+{
+    EST_ExportPipeline pipeline;
+    pipeline.channels = decoder->channels;
+
+    try {
+        if (isStream) {
+            pipeline.spare.resize(kPipelineBlocks);
+
+            for (auto &block : pipeline.spare) {
+                block.reserve(static_cast<size_t>(kExportBlockFrames) * pipeline.channels);
+            }
+        }
+    } catch (std::bad_alloc &) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    const char *error = nullptr;
+
+    pipeline.writer = CompressedOpen(type, output, decoder->channels, static_cast<int>(decoder->decoder.outputSampleRate), decoder->exportQuality, &error);
+    if (!pipeline.writer) {
+        EST_EncoderSetError(error);
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_RESULT result = EST_OK;
+
+    if (isStream) {
+        result = export_pipeline_stream(&pipeline, handle);
     } else {
+        // Already rendered, nothing left to overlap with
+        pipeline.isFailed = !CompressedWrite(pipeline.writer, EncoderOutput(decoder), static_cast<ma_uint64>(decoder->numOfPcmProcessed));
+    }
+
+    bool isWritten = CompressedClose(pipeline.writer) && !pipeline.isFailed;
+
+    if (result == EST_OK && !isWritten) {
+        EST_EncoderSetError("Failed to write export data");
+        result = EST_ERROR_ENCODER_INVALID_WRITE;
+    }
+
+    return result;
+}
+
+static EST_RESULT export_wav(EST_Encoder *decoder, EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const est_export_callbacks *output)
+{
+    bool isStream = (flags & EST_EXPORT_STREAM) != 0;
+
+    EST_ExportWriter writer;
+    export_format(type, &writer.format);
+
+    writer.channels = decoder->channels;
+    writer.isDithered = (flags & EST_EXPORT_DITHER) != 0;
+
+    // Streaming also needs the float frames of a block before they are converted
+    std::vector<float> frames;
+
+    try {
+        writer.scratch.resize(static_cast<size_t>(kExportBlockFrames) * writer.channels * ma_get_bytes_per_sample(writer.format));
+
+        if (isStream) {
+            frames.resize(static_cast<size_t>(kExportBlockFrames) * writer.channels);
+        }
+    } catch (std::bad_alloc &) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    ma_encoder_config config = ma_encoder_config_init(
+        ma_encoding_format_wav,
+        writer.format,
+        writer.channels,
+        decoder->decoder.outputSampleRate);
+
+    if (ma_encoder_init(output_write, output_seek, const_cast<est_export_callbacks *>(output), &config, &writer.encoder) != MA_SUCCESS) {
+        EST_EncoderSetError("Failed to write export data");
+        return EST_ERROR_ENCODER_INVALID_WRITE;
+    }
+
+    EST_RESULT result = EST_OK;
+
+    if (isStream) {
+        result = EST_EncoderResetStream(handle);
+
+        while (result == EST_OK) {
+            int framesRead = 0;
+
+            result = EST_EncoderReadFrames(handle, frames.data(), kExportBlockFrames, &framesRead);
+            if (result != EST_OK || framesRead == 0) {
+                break;
+            }
+
+            if (!export_write(&writer, frames.data(), static_cast<ma_uint64>(framesRead))) {
+                result = EST_ERROR_ENCODER_INVALID_WRITE;
+            }
+        }
+
+        EST_EncoderResetStream(handle);
+    } else if (!export_write(&writer, EncoderOutput(decoder), static_cast<ma_uint64>(decoder->numOfPcmProcessed))) {
+        result = EST_ERROR_ENCODER_INVALID_WRITE;
+    }
+
+    ma_encoder_uninit(&writer.encoder);
+
+    if (result == EST_ERROR_ENCODER_INVALID_WRITE) {
+        EST_EncoderSetError("Failed to write export data");
+    }
+
+    return result;
+}
+
+// Everything an export can refuse before anything is written
+static EST_Encoder *export_check(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, EST_RESULT *result)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        *result = EST_ERROR_INVALID_ARGUMENT;
+        return nullptr;
+    }
+
+    if (!EncoderOutput(decoder) && !(flags & EST_EXPORT_STREAM)) {
+        EST_EncoderSetError("Decoder not renderer");
+        *result = EST_ERROR_ENCODER_EMPTY;
+        return nullptr;
+    }
+
+    ma_format format;
+    if (!IsCompressedExport(type) && !export_format(type, &format)) {
         EST_EncoderSetError("Invalid export type or unsupported");
-        return EST_ERROR_ENCODER_UNSUPPORTED;
+        *result = EST_ERROR_ENCODER_UNSUPPORTED;
+        return nullptr;
+    }
+
+    *result = EST_OK;
+    return decoder;
+}
+
+static EST_RESULT export_run(EST_Encoder *decoder, EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const est_export_callbacks *output)
+{
+    if (IsCompressedExport(type)) {
+        return export_compressed(decoder, handle, type, (flags & EST_EXPORT_STREAM) != 0, output);
+    }
+
+    return export_wav(decoder, handle, type, flags, output);
+}
+
+EST_RESULT EST_EncoderExportFileEx(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const char *filePath)
+{
+    EST_RESULT result;
+
+    auto decoder = export_check(handle, type, flags, &result);
+    if (!decoder) {
+        return result;
+    }
+
+    if (!filePath) {
+        EST_EncoderSetError("'filePath' is nullptr");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::FILE *file = std::fopen(filePath, "wb");
+    if (!file) {
+        EST_EncoderSetError("Failed to create export file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    est_export_callbacks output = {};
+    output.write = file_write;
+    output.seek = file_seek;
+    output.userData = file;
+
+    result = export_run(decoder, handle, type, flags, &output);
+
+    if (std::fclose(file) != 0 && result == EST_OK) {
+        EST_EncoderSetError("Failed to write export data");
+        result = EST_ERROR_ENCODER_INVALID_WRITE;
     }
 
+    return result;
+}
+
+EST_RESULT EST_EncoderExportFile(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, char *filePath)
+{
+    return EST_EncoderExportFileEx(handle, type, EST_EXPORT_DEFAULT, filePath);
+}
+
+EST_RESULT EST_EncoderExportMemory(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, void **data, size_t *size)
+{
+    EST_RESULT result;
+
+    auto decoder = export_check(handle, type, flags, &result);
+    if (!decoder) {
+        return result;
+    }
+
+    if (!data || !size) {
+        EST_EncoderSetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_MemoryOutput memory;
+
+    est_export_callbacks output = {};
+    output.write = memory_write;
+    output.seek = memory_seek;
+    output.userData = &memory;
+
+    result = export_run(decoder, handle, type, flags, &output);
+    if (result != EST_OK) {
+        std::free(memory.data);
+        return result;
+    }
+
+    *data = memory.data;
+    *size = memory.size;
+
     return EST_OK;
+}
+
+EST_RESULT EST_EncoderExportCallbacks(EST_ENCODER_HANDLE handle, enum EST_FILE_EXPORT type, enum EST_EXPORT_FLAGS flags, const est_export_callbacks *output)
+{
+    EST_RESULT result;
+
+    auto decoder = export_check(handle, type, flags, &result);
+    if (decoder && (!output || !output->write)) {
+        EST_EncoderSetError("Invalid arguments");
+        result = EST_ERROR_INVALID_ARGUMENT;
+        decoder = nullptr;
+    } else if (decoder && !output->seek && !IsCompressedExport(type)) {
+        EST_EncoderSetError("WAV export needs a seek callback");
+        result = EST_ERROR_INVALID_ARGUMENT;
+        decoder = nullptr;
+    }
+
+    if (!decoder) {
+        if (output && output->close) {
+            output->close(output->userData);
+        }
+
+        return result;
+    }
+
+    result = export_run(decoder, handle, type, flags, output);
+
+    if (output->close) {
+        output->close(output->userData);
+    }
+
+    return result;
+}
+
+void EST_EncoderFreeExport(void *data)
+{
+    std::free(data);
 }
\ No newline at end of file
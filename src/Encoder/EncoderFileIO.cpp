@@ -1,7 +1,8 @@
 #include "EncoderInternal.h"
 
 namespace {
-    static std::string gErrorString;
+    // Per thread, so encoders used from different threads (or a batch) keep their own error
+    thread_local std::string gErrorString;
 }
 
 EST_RESULT InternalInit(EST_Encoder *sample, ma_format format, int channels, int sampleRate, EST_ENCODER_HANDLE *handle)
@@ -54,6 +55,11 @@ EST_RESULT InternalInit(EST_Encoder *sample, ma_format format, int channels, int
 }
 
 EST_RESULT EST_EncoderLoad(const char *path, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, EST_ENCODER_HANDLE *decoder)
+{
+    return EST_EncoderLoadWithFormat(path, callback, flags, EST_FORMAT_AUTO, decoder);
+}
+
+EST_RESULT EST_EncoderLoadWithFormat(const char *path, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, enum EST_AUDIO_FORMAT format, EST_ENCODER_HANDLE *decoder)
 {
     if (!path) {
         EST_EncoderSetError("Path is not defined");
@@ -65,22 +71,24 @@ EST_RESULT EST_EncoderLoad(const char *path, est_encoder_callback callback, enum
         return EST_ERROR_OUT_OF_MEMORY;
     }
 
-    ma_decoding_backend_vtable *pCustomBackendVTables[] = {
-        &g_ma_decoding_backend_vtable_libvorbis,
-        &g_ma_decoding_backend_vtable_libopus
-    };
-
     ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
-    config.pCustomBackendUserData = NULL;
-    config.ppCustomBackendVTables = pCustomBackendVTables;
-    config.customBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
     config.allowDynamicSampleRate = MA_TRUE;
 
-    auto result = ma_decoder_init_file(path, &config, &instance->decoder);
+    auto result = DecoderInitFile(path, &config, format, &instance->decoder);
     if (result != MA_SUCCESS) {
+        delete instance;
+        EST_EncoderSetError("Failed to load audio file");
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
+    // Offline rendering seeks freely, index Ogg pages up front
+    if (DecoderIsOgg(&instance->decoder) && BuildOggSeekIndexFile(path, instance->seekIndex)) {
+        DecoderBindSeekIndex(&instance->decoder, instance->seekIndex);
+    }
+
+    instance->sourcePath = path;
+    instance->sourceFormat = format;
+
     if (flags & EST_DECODER_MONO) {
         instance->channels = 1;
     }
@@ -95,6 +103,11 @@ EST_RESULT EST_EncoderLoad(const char *path, est_encoder_callback callback, enum
 }
 
 EST_RESULT EST_EncoderLoadMemory(const void *data, int size, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, EST_ENCODER_HANDLE *decoder)
+{
+    return EST_EncoderLoadMemoryWithFormat(data, size, callback, flags, EST_FORMAT_AUTO, decoder);
+}
+
+EST_RESULT EST_EncoderLoadMemoryWithFormat(const void *data, int size, est_encoder_callback callback, enum EST_DECODER_FLAGS flags, enum EST_AUDIO_FORMAT format, EST_ENCODER_HANDLE *decoder)
 {
     if (!data || size == 0) {
         EST_EncoderSetError("Path is not defined");
@@ -106,22 +119,24 @@ EST_RESULT EST_EncoderLoadMemory(const void *data, int size, est_encoder_callbac
         return EST_ERROR_OUT_OF_MEMORY;
     }
 
-    ma_decoding_backend_vtable *pCustomBackendVTables[] = {
-        &g_ma_decoding_backend_vtable_libvorbis,
-        &g_ma_decoding_backend_vtable_libopus
-    };
-
     ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
-    config.pCustomBackendUserData = NULL;
-    config.ppCustomBackendVTables = pCustomBackendVTables;
-    config.customBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
     config.allowDynamicSampleRate = MA_TRUE;
 
-    auto result = ma_decoder_init_memory(data, size, &config, &instance->decoder);
+    auto result = DecoderInitMemory(data, static_cast<size_t>(size), nullptr, &config, format, &instance->decoder);
     if (result != MA_SUCCESS) {
+        delete instance;
+        EST_EncoderSetError("Failed to load audio file");
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
+    if (DecoderIsOgg(&instance->decoder) && BuildOggSeekIndex(data, static_cast<size_t>(size), instance->seekIndex)) {
+        DecoderBindSeekIndex(&instance->decoder, instance->seekIndex);
+    }
+
+    instance->sourceData = data;
+    instance->sourceSize = static_cast<size_t>(size);
+    instance->sourceFormat = format;
+
     if (flags & EST_DECODER_MONO) {
         instance->channels = 1;
     }
@@ -135,6 +150,59 @@ EST_RESULT EST_EncoderLoadMemory(const void *data, int size, est_encoder_callbac
                         decoder);
 }
 
+EST_RESULT EncoderClone(EST_Encoder *encoder, EST_ENCODER_HANDLE *handle)
+{
+    EST_Encoder *instance = nullptr;
+
+    try {
+        instance = new EST_Encoder;
+        instance->sourcePath = encoder->sourcePath;
+        instance->seekIndex = encoder->seekIndex;
+    } catch (std::bad_alloc &) {
+        delete instance;
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    // The MP3 table is copied below instead of scanning the file for it
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    config.allowDynamicSampleRate = MA_TRUE;
+    config.seekPointCount = kDecoderSharedSeekTable;
+
+    auto result = encoder->sourcePath.empty()
+                      ? DecoderInitMemory(encoder->sourceData, encoder->sourceSize, nullptr, &config, encoder->sourceFormat, &instance->decoder)
+                      : DecoderInitFile(encoder->sourcePath.c_str(), &config, encoder->sourceFormat, &instance->decoder);
+
+    if (result != MA_SUCCESS) {
+        delete instance;
+        EST_EncoderSetError("Failed to load audio file");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Either encoder may be freed first, nothing is borrowed
+    DecoderCopySeekTable(&encoder->decoder, &instance->decoder);
+    if (!instance->seekIndex.empty()) {
+        DecoderBindSeekIndex(&instance->decoder, instance->seekIndex);
+    }
+
+    instance->sourceData = encoder->sourceData;
+    instance->sourceSize = encoder->sourceSize;
+    instance->sourceFormat = encoder->sourceFormat;
+    instance->sourceHash = encoder->sourceHash;
+    instance->isSourceHashed = encoder->isSourceHashed;
+
+    instance->channels = encoder->channels;
+    instance->flags = encoder->flags;
+    instance->callback = encoder->callback;
+    instance->userData = encoder->userData;
+
+    return InternalInit(instance,
+                        instance->decoder.outputFormat,
+                        instance->decoder.outputChannels,
+                        instance->decoder.outputSampleRate,
+                        handle);
+}
+
 EST_RESULT EST_EncoderFree(EST_ENCODER_HANDLE handle)
 {
     auto decoder = reinterpret_cast<EST_Encoder *>(handle);
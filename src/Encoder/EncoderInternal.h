@@ -5,12 +5,18 @@
 #include <EstEncoder.h>
 #include <EstAudio.h>
 
+#include "../Common/DecoderFormat.h"
+#include "../Common/MappedFile.h"
+#include "../Common/ParallelDecode.h"
+#include "../Common/SeekIndex.h"
 #include "../third-party/signalsmith-stretch/signalsmith-stretch.h"
 #include "../third-party/miniaudio/miniaudio_decoders.h"
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -18,6 +24,32 @@
 using namespace signalsmith::stretch;
 constexpr int kESTEncoderSignature = 255 * 0xff;
 
+enum class EST_RenderStage {
+    Idle,
+    Source, // Reading and processing the source
+    Drain,  // Flushing what the time stretcher still holds
+    Done
+};
+
+// One render pass, run whole by EST_EncoderRender or a chunk at a time by EST_EncoderReadFrames
+struct EST_RenderState
+{
+    EST_RenderStage stage = EST_RenderStage::Idle;
+    ma_uint64       targetRead = 0; // Output frames per chunk
+
+    std::vector<float> buffer; // Holds the last chunk once processed
+    std::vector<float> temp;
+
+    ma_uint64 chunkFrames = 0;
+    ma_uint64 chunkCursor = 0;     // Frames of the chunk already handed out
+    bool      isRecording = false; // Keeps the stretch stage output in EST_Encoder::stretched
+    int       drainCursor = 0;
+    int       drainFrames = 0;
+
+    std::vector<float> primeInput; // Stretcher pre-roll scratch, only grows so seeking does not allocate
+    std::vector<float> primeOutput;
+};
+
 struct EST_Encoder
 {
     const int Signature = kESTEncoderSignature;
@@ -26,20 +58,87 @@ struct EST_Encoder
     est_encoder_callback callback = NULL;
     std::vector<float>   data;
 
+    // Render mapped from the render cache or handed to a sample, read instead of data while set [see EST_EncoderSetRenderCache]
+    std::shared_ptr<EST_MappedFile>           mapped;
+    std::shared_ptr<const std::vector<float>> handedOver; // data moved out for EST_EncoderGetSample, shared with the sample
+    const float                              *mappedFrames = nullptr;
+
     ma_decoder           decoder = {};
     ma_gainer            gainer = {};
     ma_panner            panner = {};
     ma_resampler         calculator = {};
     ma_channel_converter converter = {};
 
+    std::vector<ma_ogg_seek_point> seekIndex; // Page index bound to the Ogg backend of decoder
+
+    // Where decoder reads from, reopened by the parallel decode
+    std::string           sourcePath;
+    const void           *sourceData = nullptr;
+    size_t                sourceSize = 0;
+    enum EST_AUDIO_FORMAT sourceFormat = EST_FORMAT_AUTO;
+    uint64_t              sourceHash = 0; // Content hash, keys the render cache
+    bool                  isSourceHashed = false;
+
+    // Whole source decoded ahead of a render, read instead of decoder while set.
+    // Never written once decoded, variants of one source share it [see EST_EncoderRenderVariants]
+    std::shared_ptr<const std::vector<float>> decoded;
+    ma_uint64                                 decodedFrames = 0;
+    ma_uint64                                 decodedCursor = 0;
+    unsigned int                              decodeThreads = 0; // 0 for every core
+
+    // Stretch stage output of the last full render, reused while tempo and pitch stay the same
+    std::vector<float> stretched;
+    float              stretchedRate = 0.0f;
+    float              stretchedPitch = 0.0f;
+    bool               isStretchedValid = false;
+
     float             rate = 1.0f;
     float             pitch = 1.0f;
     float             sampleRate = 44100;
     int               numOfPcmProcessed = 0;
+    float             exportQuality = 0.5f; // EST_ATTRIB_ENCODER_QUALITY
     int               channels = 2;
     EST_DECODER_FLAGS flags = EST_DECODER_UNKNOWN;
 
     std::shared_ptr<SignalsmithStretch> processor;
+    EST_RenderState                     render;
 };
 
+// A second encoder over the source of encoder, without scanning it again for seek tables or the Ogg index.
+// Callback, user data and flags are carried over, attributes are not.
+EST_RESULT EncoderClone(EST_Encoder *encoder, EST_ENCODER_HANDLE *handle);
+
+// Source access, reads the decoded copy during a render and the decoder otherwise
+ma_uint64 EncoderReadSource(EST_Encoder *encoder, float *pOutput, ma_uint64 frameCount);
+void      EncoderSeekSource(EST_Encoder *encoder, ma_uint64 frameIndex);
+
+// Decodes the whole source across every core into decoded, kept when already set and left null on failure.
+// Only done while the decoder doesn't resample (EST_ATTRIB_ENCODER_SAMPLERATE), decoded holds native frames
+bool EncoderIsNativeRate(const EST_Encoder *encoder);
+void EncoderDecodeSource(EST_Encoder *encoder);
+void EncoderReleaseSource(EST_Encoder *encoder);
+
+// Volume, pan, user callback and clipping over frames rendered up to the stretch stage, in chunk order
+void EncoderPostProcess(EST_Encoder *encoder, EST_ENCODER_HANDLE handle, ma_uint64 chunkFrames, std::vector<float> &frames);
+
+// Renders into data from stretched alone, false when tempo or pitch changed since it was kept
+bool EncoderRenderCached(EST_Encoder *encoder, EST_ENCODER_HANDLE handle);
+void EncoderKeepStretched(EST_Encoder *encoder, const float *frames, size_t count);
+
+// Rendered frames, mapped, handed over or in data, null when nothing is rendered
+const float *EncoderOutput(const EST_Encoder *encoder);
+void         EncoderResetOutput(EST_Encoder *encoder);
+
+// On-disk render cache, a hit maps the frames instead of rendering [see EST_EncoderSetRenderCache]
+bool EncoderCacheLookup(EST_Encoder *encoder, bool isParallel);
+void EncoderCacheStore(EST_Encoder *encoder, bool isParallel);
+
+// Ogg Vorbis and Ogg Opus streams written from interleaved float frames at the render rate, output only appends
+struct EST_CompressedWriter;
+
+bool                  IsCompressedExport(enum EST_FILE_EXPORT type);
+EST_CompressedWriter *CompressedOpen(enum EST_FILE_EXPORT type, const est_export_callbacks *output, int channels, int sampleRate, float quality, const char **error);
+bool                  CompressedWrite(EST_CompressedWriter *writer, const float *frames, ma_uint64 frameCount);
+bool                  CompressedClose(EST_CompressedWriter *writer); // Ends the stream and frees the writer, false when anything failed
+
 #endif
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "EncoderInternal.h"
+#include <system_error>
+
+namespace {
+    constexpr ma_uint64 kMinSegmentChunks = 300; // 3 s of output, shorter segments spend most of their time warming up
+    constexpr ma_uint64 kCrossfadeChunks = 4;    // 40 ms blended between neighbouring segments
+} // namespace
+
+// Chunk layout shared by every segment, chunk i reads the same input frames the serial render would
+struct EST_RenderPlan
+{
+    ma_uint64 targetRead = 0;   // Output frames per chunk
+    ma_uint64 inputFrames = 0;  // Input frames per chunk
+    ma_uint64 primeFrames = 0;  // Input fed ahead of chunk 0, as EST_EncoderSeek does
+    ma_uint64 chunkCount = 0;
+    ma_uint64 warmupChunks = 0; // Fed ahead of a segment so its stretcher settles before the crossfade
+    int       drainFrames = 0;  // Output flushed after the last chunk
+    int       channels = 0;
+};
+
+struct EST_RenderSegment
+{
+    ma_uint64 startChunk = 0; // Written to the output from here
+    ma_uint64 endChunk = 0;
+    bool      isLast = false;
+
+    std::vector<float> leadIn; // The crossfade chunks ahead of startChunk
+    bool               isDone = false;
+};
+
+// Input of one chunk converted to the encoder channel count, returns the frames read
+static ma_uint64 segment_read(EST_Encoder *encoder, ma_uint64 position, ma_uint64 frameCount, std::vector<float> &input, std::vector<float> &scratch)
+{
+    ma_uint64 available = encoder->decodedFrames > position ? encoder->decodedFrames - position : 0;
+    ma_uint64 frames = std::min(frameCount, available);
+    ma_uint32 sourceChannels = encoder->decoder.outputChannels;
+
+    std::fill(input.begin(), input.end(), 0.0f);
+    if (frames == 0) {
+        return 0;
+    }
+
+    const float *source = encoder->decoded->data() + position * sourceChannels;
+
+    // The converter holds no state between calls, every segment can run it at once
+    if (encoder->channels != static_cast<int>(sourceChannels)) {
+        std::copy(source, source + frames * sourceChannels, scratch.begin());
+        ma_channel_converter_process_pcm_frames(&encoder->converter, &input[0], &scratch[0], frames);
+    } else {
+        std::copy(source, source + frames * sourceChannels, input.begin());
+    }
+
+    return frames;
+}
+
+// Stretches the segment on its own stretcher, straight into its part of output
+static void segment_render(EST_Encoder *encoder, const EST_RenderPlan &plan, EST_RenderSegment *segment, float *output)
+{
+    try {
+        SignalsmithStretch stretch;
+        stretch.presetDefault(plan.channels, static_cast<float>(encoder->decoder.outputSampleRate));
+        stretch.setTransposeFactor(encoder->pitch);
+
+        size_t bufferFrames = static_cast<size_t>(std::max<ma_uint64>({ plan.inputFrames, plan.targetRead, plan.primeFrames }));
+        size_t bufferSize = bufferFrames * std::max<size_t>(plan.channels, encoder->decoder.outputChannels);
+
+        std::vector<float> input(bufferSize);
+        std::vector<float> scratch(bufferSize);
+        std::vector<float> stretched(bufferSize);
+
+        ma_uint64 leadChunks = std::min(kCrossfadeChunks, segment->startChunk);
+        ma_uint64 firstChunk = segment->startChunk - leadChunks;
+        ma_uint64 feedChunk = firstChunk > plan.warmupChunks ? firstChunk - plan.warmupChunks : 0;
+
+        segment->leadIn.assign(leadChunks * plan.targetRead * plan.channels, 0.0f);
+
+        // From the very start the stretcher is primed exactly like the serial render
+        if (feedChunk == 0 && plan.primeFrames > 0) {
+            ma_uint64 primed = segment_read(encoder, 0, plan.primeFrames, input, scratch);
+            stretch.process(input, static_cast<int>(primed), stretched, static_cast<int>(primed));
+        }
+
+        for (ma_uint64 chunk = feedChunk; chunk < segment->endChunk; chunk++) {
+            ma_uint64 position = plan.primeFrames + chunk * plan.inputFrames;
+            ma_uint64 readed = segment_read(encoder, position, plan.inputFrames, input, scratch);
+
+            std::fill(stretched.begin(), stretched.end(), 0.0f);
+            stretch.process(input, static_cast<int>(readed), stretched, static_cast<int>(plan.targetRead));
+
+            if (chunk < firstChunk) {
+                continue;
+            }
+
+            size_t chunkSize = plan.targetRead * plan.channels;
+            float *target = chunk < segment->startChunk
+                                ? &segment->leadIn[(chunk - firstChunk) * chunkSize]
+                                : output + (chunk - segment->startChunk) * chunkSize;
+
+            std::copy(stretched.begin(), stretched.begin() + chunkSize, target);
+        }
+
+        // If using timestretch, we need to process the remaining buffer
+        if (segment->isLast) {
+            float *target = output + (segment->endChunk - segment->startChunk) * plan.targetRead * plan.channels;
+
+            std::fill(input.begin(), input.end(), 0.0f);
+
+            for (int cursor = 0; cursor < plan.drainFrames;) {
+                int frames = std::min(static_cast<int>(plan.targetRead), plan.drainFrames - cursor);
+
+                stretch.process(input, 0, stretched, frames);
+                std::copy(stretched.begin(), stretched.begin() + static_cast<size_t>(frames) * plan.channels, target);
+
+                target += static_cast<size_t>(frames) * plan.channels;
+                cursor += frames;
+            }
+        }
+
+        segment->isDone = true;
+    } catch (std::bad_alloc &) {
+        segment->isDone = false;
+    }
+}
+
+EST_RESULT EST_EncoderRenderParallel(EST_ENCODER_HANDLE handle, int threadCount)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (threadCount < 0) {
+        EST_EncoderSetError("Invalid thread count");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (EncoderRenderCached(decoder, handle)) {
+        return EST_OK;
+    }
+
+    // Volume and pan alone are cheap, only the stretcher is worth spreading out
+    if (decoder->rate == 1.0f && decoder->pitch == 1.0f) {
+        return EST_EncoderRender(handle);
+    }
+
+    unsigned int threads = threadCount > 0 ? static_cast<unsigned int>(threadCount) : std::max(1u, std::thread::hardware_concurrency());
+
+    EST_RenderPlan plan;
+    plan.channels = decoder->channels;
+    plan.targetRead = static_cast<ma_uint64>(::floor(decoder->decoder.outputSampleRate * 0.01));
+    plan.inputFrames = plan.targetRead;
+
+    if (decoder->rate != 1.0f) {
+        ma_resampler_get_required_input_frame_count(&decoder->calculator, plan.targetRead, &plan.inputFrames);
+    }
+
+    {
+        SignalsmithStretch probe;
+        probe.presetDefault(plan.channels, static_cast<float>(decoder->decoder.outputSampleRate));
+
+        plan.primeFrames = static_cast<ma_uint64>(probe.inputLatency()) * 2;
+        plan.drainFrames = probe.outputLatency();
+
+        ma_uint64 latency = static_cast<ma_uint64>(probe.inputLatency() + probe.outputLatency()) * 2;
+        plan.warmupChunks = (latency + plan.inputFrames - 1) / std::max<ma_uint64>(1, plan.inputFrames) + 1;
+    }
+
+    ma_uint64 length = 0;
+    ma_decoder_get_length_in_pcm_frames(&decoder->decoder, &length);
+
+    ma_uint64 chunkCount = length > plan.primeFrames && plan.inputFrames > 0 ? (length - plan.primeFrames + plan.inputFrames - 1) / plan.inputFrames : 0;
+    ma_uint64 segmentCount = std::min<ma_uint64>(threads, chunkCount / kMinSegmentChunks);
+
+    if (segmentCount < 2) {
+        return EST_EncoderRender(handle);
+    }
+
+    EncoderResetOutput(decoder);
+
+    if (EncoderCacheLookup(decoder, true)) {
+        return EST_OK;
+    }
+
+    EncoderDecodeSource(decoder);
+    if (!decoder->decoded) {
+        return EST_EncoderRender(handle);
+    }
+
+    // The decoded length is exact where the reported one may not be
+    plan.chunkCount = decoder->decodedFrames > plan.primeFrames ? (decoder->decodedFrames - plan.primeFrames + plan.inputFrames - 1) / plan.inputFrames : 0;
+    segmentCount = std::min<ma_uint64>(segmentCount, plan.chunkCount / kMinSegmentChunks);
+
+    if (segmentCount < 2) {
+        return EST_EncoderRender(handle);
+    }
+
+    std::vector<float>             frames;
+    std::vector<EST_RenderSegment> segments;
+
+    try {
+        frames.assign((plan.chunkCount * plan.targetRead + plan.drainFrames) * plan.channels, 0.0f);
+        segments.resize(segmentCount);
+    } catch (std::bad_alloc &) {
+        EncoderReleaseSource(decoder);
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    ma_uint64 segmentChunks = plan.chunkCount / segmentCount;
+    for (ma_uint64 i = 0; i < segmentCount; i++) {
+        segments[i].startChunk = i * segmentChunks;
+        segments[i].endChunk = (i + 1 == segmentCount) ? plan.chunkCount : (i + 1) * segmentChunks;
+        segments[i].isLast = i + 1 == segmentCount;
+    }
+
+    std::vector<std::thread> workers;
+
+    try {
+        workers.reserve(segmentCount - 1);
+
+        for (ma_uint64 i = 1; i < segmentCount; i++) {
+            workers.emplace_back([&, i] {
+                segment_render(decoder, plan, &segments[i], &frames[segments[i].startChunk * plan.targetRead * plan.channels]);
+            });
+        }
+    } catch (std::exception &) {
+        // Out of threads or memory, segments without a thread stay undone and are rendered here after the join
+    }
+
+    segment_render(decoder, plan, &segments[0], frames.data());
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    for (auto &segment : segments) {
+        if (!segment.isDone) {
+            segment_render(decoder, plan, &segment, &frames[segment.startChunk * plan.targetRead * plan.channels]);
+        }
+
+        if (!segment.isDone) {
+            EncoderReleaseSource(decoder);
+            EST_EncoderSetError("Out of memory!");
+            return EST_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    // Linear crossfade into each segment, both sides stretch the same input so they are correlated
+    for (ma_uint64 i = 1; i < segmentCount; i++) {
+        const std::vector<float> &leadIn = segments[i].leadIn;
+
+        size_t leadFrames = leadIn.size() / plan.channels;
+        float *target = &frames[segments[i].startChunk * plan.targetRead * plan.channels] - leadIn.size();
+
+        for (size_t f = 0; f < leadFrames; f++) {
+            float fade = static_cast<float>(f + 1) / static_cast<float>(leadFrames + 1);
+
+            for (int c = 0; c < plan.channels; c++) {
+                size_t index = f * plan.channels + c;
+                target[index] = target[index] * (1.0f - fade) + leadIn[index] * fade;
+            }
+        }
+    }
+
+    // Leave the decoder where the source ended, the decoded copy stays for later renders
+    ma_decoder_seek_to_pcm_frame(&decoder->decoder, decoder->decodedFrames);
+
+    EncoderKeepStretched(decoder, frames.data(), frames.size());
+    EncoderPostProcess(decoder, handle, plan.targetRead, frames);
+
+    decoder->data = std::move(frames);
+    decoder->numOfPcmProcessed = static_cast<int>(decoder->data.size() / plan.channels);
+    decoder->render.stage = EST_RenderStage::Idle;
+
+    EncoderCacheStore(decoder, true);
+
+    return EST_OK;
+}
\ No newline at end of file
@@ -1,5 +1,205 @@
 #include "EncoderInternal.h"
 
+ma_uint64 EncoderReadSource(EST_Encoder *encoder, float *pOutput, ma_uint64 frameCount)
+{
+    if (!encoder->decoded) {
+        ma_uint64 framesRead = 0;
+        ma_decoder_read_pcm_frames(&encoder->decoder, pOutput, frameCount, &framesRead);
+        return framesRead;
+    }
+
+    ma_uint32 channels = encoder->decoder.outputChannels;
+    ma_uint64 framesRead = std::min(frameCount, encoder->decodedFrames - encoder->decodedCursor);
+
+    std::copy_n(encoder->decoded->data() + encoder->decodedCursor * channels, framesRead * channels, pOutput);
+    encoder->decodedCursor += framesRead;
+
+    return framesRead;
+}
+
+void EncoderSeekSource(EST_Encoder *encoder, ma_uint64 frameIndex)
+{
+    if (!encoder->decoded) {
+        ma_decoder_seek_to_pcm_frame(&encoder->decoder, frameIndex);
+    } else {
+        encoder->decodedCursor = std::min(frameIndex, encoder->decodedFrames);
+    }
+}
+
+bool EncoderIsNativeRate(const EST_Encoder *encoder)
+{
+    const ma_data_converter &converter = encoder->decoder.converter;
+    return !converter.hasResampler || converter.resampler.sampleRateIn == converter.resampler.sampleRateOut;
+}
+
+// Decodes the whole source across every core, the render then reads memory only
+void EncoderDecodeSource(EST_Encoder *encoder)
+{
+    EST_DecodeSource source;
+    source.path = encoder->sourcePath.empty() ? nullptr : encoder->sourcePath.c_str();
+    source.data = encoder->sourceData;
+    source.size = encoder->sourceSize;
+    source.format = encoder->sourceFormat;
+
+    // A rate mod resamples in the decoder, the native frames would play it back unmodded
+    if (encoder->decoded || (!source.path && !source.data) || !EncoderIsNativeRate(encoder)) {
+        return;
+    }
+
+    std::vector<float> frames;
+    ma_uint32          channels = 0;
+    ma_uint32          sampleRate = 0;
+
+    if (DecodeParallel(source, encoder->decodeThreads, frames, &channels, &sampleRate) != MA_SUCCESS ||
+        channels != encoder->decoder.outputChannels ||
+        sampleRate != encoder->decoder.outputSampleRate) {
+        // The decoder still works, just slower
+        return;
+    }
+
+    try {
+        encoder->decoded = std::make_shared<const std::vector<float>>(std::move(frames));
+    } catch (std::bad_alloc &) {
+        return;
+    }
+
+    encoder->decodedFrames = encoder->decoded->size() / channels;
+    encoder->decodedCursor = 0;
+}
+
+void EncoderReleaseSource(EST_Encoder *encoder)
+{
+    encoder->decoded.reset();
+    encoder->decodedFrames = 0;
+    encoder->decodedCursor = 0;
+}
+
+// Volume, pan, user callback and clipping, in chunk order on this thread like the serial render
+void EncoderPostProcess(EST_Encoder *encoder, EST_ENCODER_HANDLE handle, ma_uint64 chunkFrames, std::vector<float> &frames)
+{
+    std::vector<float> temp(chunkFrames * encoder->channels);
+    ma_uint64          total = frames.size() / encoder->channels;
+
+    for (ma_uint64 cursor = 0; cursor < total;) {
+        ma_uint64 count = std::min(chunkFrames, total - cursor);
+        float    *chunk = &frames[cursor * encoder->channels];
+
+        ma_gainer_process_pcm_frames(&encoder->gainer, &temp[0], chunk, count);
+        ma_panner_process_pcm_frames(&encoder->panner, chunk, &temp[0], count);
+
+        if (encoder->callback) {
+            encoder->callback(handle, encoder->userData, chunk, static_cast<int>(count));
+        }
+
+        // Clip the audio data to prevent distortion
+        for (ma_uint64 i = 0; i < count * encoder->channels; i++) {
+            chunk[i] = std::clamp(chunk[i], -1.0f, 1.0f);
+        }
+
+        cursor += count;
+    }
+}
+
+const float *EncoderOutput(const EST_Encoder *encoder)
+{
+    if (encoder->mappedFrames) {
+        return encoder->mappedFrames;
+    }
+
+    return encoder->data.empty() ? nullptr : encoder->data.data();
+}
+
+void EncoderResetOutput(EST_Encoder *encoder)
+{
+    encoder->data.clear();
+    encoder->mapped.reset();
+    encoder->handedOver.reset();
+    encoder->mappedFrames = nullptr;
+    encoder->numOfPcmProcessed = 0;
+}
+
+bool EncoderRenderCached(EST_Encoder *encoder, EST_ENCODER_HANDLE handle)
+{
+    if (!encoder->isStretchedValid || encoder->stretchedRate != encoder->rate || encoder->stretchedPitch != encoder->pitch) {
+        return false;
+    }
+
+    EncoderResetOutput(encoder);
+
+    try {
+        encoder->data = encoder->stretched;
+    } catch (std::bad_alloc &) {
+        return false;
+    }
+
+    ma_uint64 chunkFrames = static_cast<ma_uint64>(::floor(encoder->decoder.outputSampleRate * 0.01));
+
+    EncoderPostProcess(encoder, handle, std::max<ma_uint64>(1, chunkFrames), encoder->data);
+    encoder->numOfPcmProcessed = static_cast<int>(encoder->data.size() / encoder->channels);
+    encoder->render.stage = EST_RenderStage::Idle;
+
+    return true;
+}
+
+void EncoderKeepStretched(EST_Encoder *encoder, const float *frames, size_t count)
+{
+    try {
+        encoder->stretched.assign(frames, frames + count);
+    } catch (std::bad_alloc &) {
+        std::vector<float>().swap(encoder->stretched);
+        encoder->isStretchedValid = false;
+        return;
+    }
+
+    encoder->stretchedRate = encoder->rate;
+    encoder->stretchedPitch = encoder->pitch;
+    encoder->isStretchedValid = true;
+}
+
+// Feeds the stretcher the frames from index on and drops its output so the next chunk lines up with index,
+// the scratch in the render state only grows so seeking again does not allocate
+static bool encoder_prime(EST_Encoder *encoder, ma_uint64 index)
+{
+    EST_RenderState &state = encoder->render;
+
+    EncoderSeekSource(encoder, index);
+
+    if (encoder->rate == 1.0f && encoder->pitch == 1.0f) {
+        return true;
+    }
+
+    encoder->processor->reset();
+
+    int    latency = encoder->processor->inputLatency() * 2;
+    size_t size = static_cast<size_t>(latency) * std::max<int>(encoder->channels, encoder->decoder.outputChannels);
+
+    try {
+        if (state.primeInput.size() < size) {
+            state.primeInput.resize(size);
+        }
+
+        if (state.primeOutput.size() < size) {
+            state.primeOutput.resize(size);
+        }
+    } catch (std::bad_alloc &) {
+        return false;
+    }
+
+    ma_uint64 readed = 0;
+
+    if (encoder->channels != (int)encoder->decoder.outputChannels) {
+        readed = EncoderReadSource(encoder, &state.primeOutput[0], latency);
+
+        ma_channel_converter_process_pcm_frames(&encoder->converter, &state.primeInput[0], &state.primeOutput[0], readed);
+    } else {
+        readed = EncoderReadSource(encoder, &state.primeInput[0], latency);
+    }
+
+    encoder->processor->process(state.primeInput, static_cast<int>(readed), state.primeOutput, static_cast<int>(readed));
+
+    return true;
+}
+
 EST_RESULT EST_EncoderSeek(EST_ENCODER_HANDLE handle, int index)
 {
     auto decoder = reinterpret_cast<EST_Encoder *>(handle);
@@ -8,38 +208,232 @@ EST_RESULT EST_EncoderSeek(EST_ENCODER_HANDLE handle, int index)
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
-    ma_decoder_seek_to_pcm_frame(&decoder->decoder, index);
-
     // If using timestretch, we need to process initial buffer
-    if (decoder->rate != 1.0f || decoder->pitch != 1.0f) {
-        decoder->processor->reset();
+    if (!encoder_prime(decoder, static_cast<ma_uint64>(index))) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    return EST_OK;
+}
+
+/*
+ * This is bit tricky, as I want my encoder to support both resampler and timestretch
+ *
+ * My workflow is:
+ * 1. Process resampler
+ * 2. -=- timestretch
+ * 3. -=- vol/pan
+ * 4. -=- user-callback
+ * 5. -=- clipping
+ */
+
+static bool encoder_is_stretched(EST_Encoder *encoder)
+{
+    return encoder->rate != 1.0f || encoder->pitch != 1.0f;
+}
+
+// Rewinds the source and the effects to start, wholeSource decodes everything up front (memory for speed)
+static bool encoder_render_begin(EST_Encoder *encoder, bool wholeSource, ma_uint64 start)
+{
+    EST_RenderState &state = encoder->render;
+
+    state.targetRead = static_cast<ma_uint64>(::floor(encoder->decoder.outputSampleRate * 0.01));
+
+    encoder->processor->reset();
+    encoder->processor->presetDefault(
+        static_cast<int>(encoder->channels),
+        static_cast<float>(encoder->decoder.outputSampleRate));
+
+    int bufferSize = static_cast<int>(::floor(state.targetRead * encoder->decoder.outputChannels * encoder->rate));
+    state.buffer.assign(bufferSize, 0.0f);
+    state.temp.assign(bufferSize, 0.0f);
+    state.chunkFrames = 0;
+    state.chunkCursor = 0;
+    state.drainCursor = 0;
+    state.drainFrames = 0;
+
+    if (wholeSource) {
+        EncoderDecodeSource(encoder);
+    }
+
+    if (!encoder_prime(encoder, start)) {
+        return false;
+    }
+
+    state.stage = EST_RenderStage::Source;
+    return true;
+}
+
+static void encoder_render_end(EST_Encoder *encoder)
+{
+    EST_RenderState &state = encoder->render;
+
+    // Leave the decoder where the decoded copy ended, the copy stays for later renders
+    if (encoder->decoded) {
+        ma_decoder_seek_to_pcm_frame(&encoder->decoder, encoder->decodedCursor);
+    }
+
+    std::vector<float>().swap(state.buffer);
+    std::vector<float>().swap(state.temp);
+    state.chunkFrames = 0;
+    state.chunkCursor = 0;
+    state.isRecording = false;
+    state.stage = EST_RenderStage::Done;
+}
+
+// Keeps the stretch stage output of a chunk, a full render keeps the whole source this way
+static void encoder_record(EST_Encoder *encoder, ma_uint64 frames)
+{
+    EST_RenderState &state = encoder->render;
+    if (!state.isRecording) {
+        return;
+    }
+
+    try {
+        encoder->stretched.insert(encoder->stretched.end(), state.buffer.begin(), state.buffer.begin() + frames * encoder->channels);
+    } catch (std::bad_alloc &) {
+        // Nothing kept, the next render just does the whole chain again
+        std::vector<float>().swap(encoder->stretched);
+        state.isRecording = false;
+    }
+}
+
+// One chunk of the source into state.buffer, 0 once the source ends
+static ma_uint64 encoder_render_source(EST_Encoder *encoder, EST_ENCODER_HANDLE handle)
+{
+    EST_RenderState &state = encoder->render;
+    auto            &buffer = state.buffer;
+    auto            &temp = state.temp;
+
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    std::fill(temp.begin(), temp.end(), 0.0f);
+
+    ma_uint64 targetThisIteration = state.targetRead;
+    if (encoder->rate != 1.0f) {
+        ma_resampler_get_required_input_frame_count(
+            &encoder->calculator,
+            state.targetRead,
+            &targetThisIteration);
+    }
+
+    ma_uint64 readed = EncoderReadSource(encoder, &buffer[0], targetThisIteration);
+    if (readed == 0) {
+        return 0;
+    }
+
+    if (encoder->channels != static_cast<int>(encoder->decoder.outputChannels)) {
+        ma_channel_converter_process_pcm_frames(&encoder->converter, &temp[0], &buffer[0], readed);
+
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        std::copy(&temp[0], &temp[0] + readed * encoder->channels, &buffer[0]);
+    }
+
+    // Effect processing
+    if (encoder_is_stretched(encoder)) {
+        encoder->processor->process(
+            buffer,
+            static_cast<int>(readed),
+            temp,
+            static_cast<int>(state.targetRead));
+
+        readed = state.targetRead;
+
+        std::copy(&temp[0], &temp[0] + readed * encoder->channels, &buffer[0]);
+    }
+
+    encoder_record(encoder, readed);
+
+    if (ma_gainer_process_pcm_frames(&encoder->gainer, &temp[0], &buffer[0], readed) != MA_SUCCESS) {
+        return 0;
+    }
+
+    if (ma_panner_process_pcm_frames(&encoder->panner, &buffer[0], &temp[0], readed) != MA_SUCCESS) {
+        return 0;
+    }
+
+    // User-default callback
+    if (encoder->callback) {
+        encoder->callback(handle, encoder->userData, &buffer[0], static_cast<int>(readed));
+    }
+
+    return readed;
+}
 
-        int latency = decoder->processor->inputLatency() * 2;
-        int readed = 0;
+// One chunk of what the time stretcher still holds, 0 once it is empty
+static ma_uint64 encoder_render_drain(EST_Encoder *encoder, EST_ENCODER_HANDLE handle)
+{
+    EST_RenderState &state = encoder->render;
+    auto            &buffer = state.buffer;
+    auto            &temp = state.temp;
+
+    if (state.drainCursor >= state.drainFrames) {
+        return 0;
+    }
 
-        std::vector<float> convertedData(latency * decoder->channels);
+    ma_uint64 frameToRead = std::min<ma_uint64>(state.targetRead, static_cast<ma_uint64>(state.drainFrames - state.drainCursor));
 
-        if (decoder->channels != (int)decoder->decoder.outputChannels) {
-            std::vector<float> encoderData(latency * decoder->decoder.outputChannels);
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    std::fill(temp.begin(), temp.end(), 0.0f);
 
-            ma_uint64 ma_readed = 0;
-            ma_decoder_read_pcm_frames(&decoder->decoder, &encoderData[0], latency, &ma_readed);
+    encoder->processor->process(
+        temp,
+        0,
+        buffer,
+        static_cast<int>(frameToRead));
 
-            ma_channel_converter_process_pcm_frames(&decoder->converter, &convertedData[0], &encoderData[0], ma_readed);
+    encoder_record(encoder, frameToRead);
+
+    if (ma_gainer_process_pcm_frames(&encoder->gainer, &temp[0], &buffer[0], frameToRead) != MA_SUCCESS) {
+        return 0;
+    }
+
+    if (ma_panner_process_pcm_frames(&encoder->panner, &buffer[0], &temp[0], frameToRead) != MA_SUCCESS) {
+        return 0;
+    }
+
+    if (encoder->callback) {
+        encoder->callback(handle, encoder->userData, &buffer[0], static_cast<int>(frameToRead));
+    }
 
-            readed = static_cast<int>(ma_readed);
-        } else {
-            ma_uint64 ma_readed = 0;
-            ma_decoder_read_pcm_frames(&decoder->decoder, &convertedData[0], latency, &ma_readed);
+    state.drainCursor += static_cast<int>(frameToRead);
 
-            readed = static_cast<int>(ma_readed);
+    return frameToRead;
+}
+
+// Renders the next chunk into state.buffer, clipped, 0 once the render is done
+static ma_uint64 encoder_render_chunk(EST_Encoder *encoder, EST_ENCODER_HANDLE handle)
+{
+    EST_RenderState &state = encoder->render;
+    ma_uint64        frames = 0;
+
+    if (state.stage == EST_RenderStage::Source) {
+        frames = encoder_render_source(encoder, handle);
+
+        // If using timestretch, we need to process the remaining buffer
+        if (frames == 0) {
+            state.stage = encoder_is_stretched(encoder) ? EST_RenderStage::Drain : EST_RenderStage::Done;
+            state.drainCursor = 0;
+            state.drainFrames = encoder->processor->outputLatency();
         }
+    }
 
-        std::vector<float> outputProcess(convertedData.size());
-        decoder->processor->process(convertedData, readed, outputProcess, readed);
+    if (state.stage == EST_RenderStage::Drain) {
+        frames = encoder_render_drain(encoder, handle);
+        if (frames == 0) {
+            state.stage = EST_RenderStage::Done;
+        }
     }
 
-    return EST_OK;
+    // Clip the audio data to prevent distortion
+    for (ma_uint64 i = 0; i < frames * encoder->channels; i++) {
+        state.buffer[i] = std::clamp(state.buffer[i], -1.0f, 1.0f);
+    }
+
+    state.chunkFrames = frames;
+    state.chunkCursor = 0;
+
+    return frames;
 }
 
 EST_RESULT EST_EncoderRender(EST_ENCODER_HANDLE handle)
@@ -50,144 +444,218 @@ EST_RESULT EST_EncoderRender(EST_ENCODER_HANDLE handle)
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
-    ma_uint64 targetRead = static_cast<ma_uint64>(::floor(decoder->decoder.outputSampleRate * 0.01));
+    if (EncoderRenderCached(decoder, handle)) {
+        return EST_OK;
+    }
 
-    decoder->data.clear();
-    decoder->data.resize(0);
-    decoder->processor->reset();
-    decoder->processor->presetDefault(
-        static_cast<int>(decoder->channels),
-        static_cast<float>(decoder->decoder.outputSampleRate));
-    decoder->numOfPcmProcessed = 0;
+    EncoderResetOutput(decoder);
 
-    int                bufferSize = static_cast<int>(::floor(targetRead * decoder->decoder.outputChannels * decoder->rate));
-    std::vector<float> buffer(bufferSize);
-    std::vector<float> temp(buffer.size());
+    if (EncoderCacheLookup(decoder, false)) {
+        return EST_OK;
+    }
 
-    /*
-     * This is bit tricky, as I want my encoder to support both resampler and timestretch
-     *
-     * My workflow is:
-     * 1. Process resampler
-     * 2. -=- timestretch
-     * 3. -=- vol/pan
-     * 4. -=- user-callback
-     * 5. -=- clipping
-     */
+    if (!encoder_render_begin(decoder, true, 0)) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
 
-    EST_EncoderSeek(handle, 0);
+    decoder->stretched.clear();
+    decoder->isStretchedValid = false;
+    decoder->render.isRecording = true;
 
     while (true) {
-        std::fill(buffer.begin(), buffer.end(), 0.0f);
-        std::fill(temp.begin(), temp.end(), 0.0f);
-
-        ma_uint64 targetThisIteration = targetRead;
-        if (decoder->rate != 1.0f) {
-            ma_resampler_get_required_input_frame_count(
-                &decoder->calculator,
-                targetRead,
-                &targetThisIteration);
-        }
-
-        ma_uint64 readed = 0;
-        auto      result = ma_decoder_read_pcm_frames(&decoder->decoder, &buffer[0], targetThisIteration, &readed);
-        if (result != MA_SUCCESS || readed == 0) {
+        ma_uint64 frames = encoder_render_chunk(decoder, handle);
+        if (frames == 0) {
             break;
         }
 
-        if (decoder->channels != static_cast<int>(decoder->decoder.outputChannels)) {
-            ma_channel_converter_process_pcm_frames(&decoder->converter, &temp[0], &buffer[0], readed);
+        auto &buffer = decoder->render.buffer;
+        std::copy(&buffer[0], &buffer[0] + frames * decoder->channels, std::back_inserter(decoder->data));
 
-            std::fill(buffer.begin(), buffer.end(), 0.0f);
-            std::copy(&temp[0], &temp[0] + readed * decoder->channels, &buffer[0]);
-        }
+        decoder->numOfPcmProcessed += static_cast<int>(frames);
+    }
 
-        // Effect processing
-        {
-            if (decoder->rate != 1.0f || decoder->pitch != 1.0f) {
-                decoder->processor->process(
-                    buffer,
-                    static_cast<int>(readed),
-                    temp,
-                    static_cast<int>(targetRead));
-
-                readed = targetRead;
-
-                std::copy(&temp[0], &temp[0] + readed * decoder->channels, &buffer[0]);
-            }
-
-            result = ma_gainer_process_pcm_frames(&decoder->gainer, &temp[0], &buffer[0], readed);
-            if (result != MA_SUCCESS) {
-                break;
-            }
-
-            result = ma_panner_process_pcm_frames(&decoder->panner, &buffer[0], &temp[0], readed);
-            if (result != MA_SUCCESS) {
-                break;
-            }
-        }
+    if (decoder->render.isRecording) {
+        decoder->stretchedRate = decoder->rate;
+        decoder->stretchedPitch = decoder->pitch;
+        decoder->isStretchedValid = true;
+    }
+
+    encoder_render_end(decoder);
+
+    // A later pull starts over from the beginning
+    decoder->render.stage = EST_RenderStage::Idle;
+
+    EncoderCacheStore(decoder, false);
 
-        int totalReadedThisIteration = static_cast<int>(readed);
+    return EST_OK;
+}
+
+EST_RESULT EST_EncoderRenderRange(EST_ENCODER_HANDLE handle, long long start, long long end, enum EST_RANGE_UNIT unit)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (start < 0 || end <= start || (unit != EST_RANGE_SOURCE && unit != EST_RANGE_OUTPUT)) {
+        EST_EncoderSetError("Invalid range");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The render reads inputFrames of the source for every targetRead frames it outputs
+    ma_uint64 targetRead = std::max<ma_uint64>(1, static_cast<ma_uint64>(::floor(decoder->decoder.outputSampleRate * 0.01)));
+    ma_uint64 inputFrames = targetRead;
+    if (decoder->rate != 1.0f) {
+        ma_resampler_get_required_input_frame_count(&decoder->calculator, targetRead, &inputFrames);
+        inputFrames = std::max<ma_uint64>(1, inputFrames);
+    }
+
+    double    scale = static_cast<double>(targetRead) / static_cast<double>(inputFrames);
+    ma_uint64 sourceStart = 0;
+    ma_uint64 outputStart = 0;
+    ma_uint64 outputFrames = 0;
+
+    if (unit == EST_RANGE_SOURCE) {
+        sourceStart = static_cast<ma_uint64>(start);
+        outputStart = static_cast<ma_uint64>(::floor(start * scale));
+        outputFrames = static_cast<ma_uint64>(::ceil((end - start) * scale));
+    } else {
+        sourceStart = static_cast<ma_uint64>(::floor(start / scale));
+        outputStart = static_cast<ma_uint64>(start);
+        outputFrames = static_cast<ma_uint64>(end - start);
+    }
+
+    ma_uint64 length = decoder->decoded ? decoder->decodedFrames : 0;
+    if (!decoder->decoded) {
+        ma_decoder_get_length_in_pcm_frames(&decoder->decoder, &length);
+    }
 
-        // User-default callback
-        if (decoder->callback) {
-            decoder->callback(handle, decoder->userData, &buffer[0], totalReadedThisIteration);
+    if (length > 0 && sourceStart >= length) {
+        EST_EncoderSetError("Range starts past the end of the source");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EncoderResetOutput(decoder);
+
+    // A full render is kept, the range is a slice of it
+    if (decoder->isStretchedValid && decoder->stretchedRate == decoder->rate && decoder->stretchedPitch == decoder->pitch) {
+        ma_uint64 total = decoder->stretched.size() / decoder->channels;
+        ma_uint64 first = std::min(outputStart, total);
+        ma_uint64 last = outputFrames > total - first ? total : first + outputFrames;
+
+        try {
+            decoder->data.assign(
+                decoder->stretched.begin() + first * decoder->channels,
+                decoder->stretched.begin() + last * decoder->channels);
+        } catch (std::bad_alloc &) {
+            EST_EncoderSetError("Out of memory!");
+            return EST_ERROR_OUT_OF_MEMORY;
         }
 
-        int sizeToCopy = totalReadedThisIteration * decoder->channels;
-        std::copy(&buffer[0], &buffer[0] + sizeToCopy, std::back_inserter(decoder->data));
+        EncoderPostProcess(decoder, handle, targetRead, decoder->data);
+        decoder->numOfPcmProcessed = static_cast<int>(last - first);
+        decoder->render.stage = EST_RenderStage::Idle;
 
-        decoder->numOfPcmProcessed += totalReadedThisIteration;
+        return EST_OK;
     }
 
-    // If using timestretch, we need to process the remaining buffer
-    if (decoder->rate != 1.0f || decoder->pitch != 1.0f) {
-        int outputBuffer = decoder->processor->outputLatency();
+    // Only the range is read, the tail past the source end is what the stretcher still holds
+    ma_uint64 reserveFrames = outputFrames;
+    if (length > 0) {
+        reserveFrames = std::min<ma_uint64>(reserveFrames, static_cast<ma_uint64>(::ceil((length - sourceStart) * scale)) + targetRead * 2);
+    }
 
-        int currentCursor = 0;
-        while (currentCursor < outputBuffer) {
-            ma_uint64 frameToRead = targetRead;
+    try {
+        decoder->data.reserve(reserveFrames * decoder->channels);
+    } catch (std::bad_alloc &) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
 
-            if (currentCursor + targetRead > outputBuffer) {
-                frameToRead = outputBuffer - currentCursor;
-            }
+    if (!encoder_render_begin(decoder, false, sourceStart)) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
 
-            std::fill(buffer.begin(), buffer.end(), 0.0f);
-            std::fill(temp.begin(), temp.end(), 0.0f);
+    while (static_cast<ma_uint64>(decoder->numOfPcmProcessed) < outputFrames) {
+        ma_uint64 frames = encoder_render_chunk(decoder, handle);
+        if (frames == 0) {
+            break;
+        }
 
-            decoder->processor->process(
-                temp,
-                0,
-                buffer,
-                static_cast<int>(frameToRead));
+        frames = std::min<ma_uint64>(frames, outputFrames - decoder->numOfPcmProcessed);
 
-            auto result = ma_gainer_process_pcm_frames(&decoder->gainer, &temp[0], &buffer[0], frameToRead);
-            if (result != MA_SUCCESS) {
-                break;
-            }
+        auto &buffer = decoder->render.buffer;
+        std::copy(&buffer[0], &buffer[0] + frames * decoder->channels, std::back_inserter(decoder->data));
 
-            result = ma_panner_process_pcm_frames(&decoder->panner, &buffer[0], &temp[0], frameToRead);
-            if (result != MA_SUCCESS) {
-                break;
-            }
+        decoder->numOfPcmProcessed += static_cast<int>(frames);
+    }
 
-            if (decoder->callback) {
-                decoder->callback(handle, decoder->userData, &buffer[0], static_cast<int>(frameToRead));
-            }
+    encoder_render_end(decoder);
+    decoder->render.stage = EST_RenderStage::Idle;
 
-            int sizeToCopy = static_cast<int>(frameToRead) * decoder->channels;
-            std::copy(&buffer[0], &buffer[0] + sizeToCopy, std::back_inserter(decoder->data));
+    return EST_OK;
+}
 
-            currentCursor += static_cast<int>(frameToRead);
-            decoder->numOfPcmProcessed += static_cast<int>(frameToRead);
+EST_RESULT EST_EncoderReadFrames(EST_ENCODER_HANDLE handle, float *data, int maxFrames, int *framesRead)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!data || maxFrames < 0 || !framesRead) {
+        EST_EncoderSetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EST_RenderState &state = decoder->render;
+
+    // Streams straight from the decoder, memory stays at one chunk however long the source is
+    if (state.stage == EST_RenderStage::Idle && !encoder_render_begin(decoder, false, 0)) {
+        EST_EncoderSetError("Out of memory!");
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    int written = 0;
+
+    while (written < maxFrames && state.stage != EST_RenderStage::Done) {
+        if (state.chunkCursor == state.chunkFrames && encoder_render_chunk(decoder, handle) == 0) {
+            encoder_render_end(decoder);
+            break;
         }
+
+        ma_uint64    frames = std::min<ma_uint64>(state.chunkFrames - state.chunkCursor, static_cast<ma_uint64>(maxFrames - written));
+        const float *chunk = &state.buffer[state.chunkCursor * decoder->channels];
+
+        std::copy(chunk, chunk + frames * decoder->channels, data + static_cast<size_t>(written) * decoder->channels);
+
+        state.chunkCursor += frames;
+        written += static_cast<int>(frames);
     }
 
-    // Clip the audio data to prevent distortion
-    for (int i = 0; i < decoder->data.size(); i++) {
-        decoder->data[i] = std::clamp(decoder->data[i], -1.0f, 1.0f);
+    *framesRead = written;
+
+    return EST_OK;
+}
+
+EST_RESULT EST_EncoderResetStream(EST_ENCODER_HANDLE handle)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
     }
 
+    if (decoder->render.stage != EST_RenderStage::Idle && decoder->render.stage != EST_RenderStage::Done) {
+        encoder_render_end(decoder);
+    }
+
+    decoder->render.stage = EST_RenderStage::Idle;
+
     return EST_OK;
 }
 
@@ -199,13 +667,15 @@ EST_RESULT EST_EncoderGetData(EST_ENCODER_HANDLE handle, void *data, int *size)
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
-    if (decoder->numOfPcmProcessed > 0) {
+    const float *output = EncoderOutput(decoder);
+
+    if (decoder->numOfPcmProcessed > 0 && output) {
         float *pData = static_cast<float *>(data);
         int    numOfFloatBytes = decoder->numOfPcmProcessed * decoder->channels;
 
         std::copy(
-            &decoder->data[0],
-            &decoder->data[0] + numOfFloatBytes,
+            output,
+            output + numOfFloatBytes,
             pData);
 
         *size = decoder->numOfPcmProcessed;
@@ -224,8 +694,23 @@ EST_RESULT EST_EncoderFlushData(EST_ENCODER_HANDLE handle)
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
-    decoder->data.resize(0);
-    decoder->numOfPcmProcessed = 0;
+    EncoderResetOutput(decoder);
+
+    return EST_OK;
+}
+
+EST_RESULT EST_EncoderReleaseCache(EST_ENCODER_HANDLE handle)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    EncoderReleaseSource(decoder);
+
+    std::vector<float>().swap(decoder->stretched);
+    decoder->isStretchedValid = false;
 
     return EST_OK;
 }
@@ -243,6 +728,29 @@ EST_RESULT EST_EncoderGetAvailableDataSize(EST_ENCODER_HANDLE handle, int *size)
     return EST_OK;
 }
 
+// Makes the decoder resample to rate, everything rendered or kept at the old rate is dropped
+static bool encoder_set_output_rate(EST_Encoder *encoder, ma_uint32 rate)
+{
+    if (rate == encoder->decoder.outputSampleRate) {
+        return true;
+    }
+
+    // EST_ATTRIB_ENCODER_SAMPLERATE stays the input side of the conversion
+    if (ma_data_converter_set_rate(&encoder->decoder.converter, static_cast<ma_uint32>(encoder->sampleRate), rate) != MA_SUCCESS) {
+        return false;
+    }
+
+    encoder->decoder.outputSampleRate = rate;
+    ma_resampler_set_rate(&encoder->calculator, static_cast<ma_uint32>(rate * encoder->rate), rate);
+
+    EncoderReleaseSource(encoder);
+    EncoderResetOutput(encoder);
+    std::vector<float>().swap(encoder->stretched);
+    encoder->isStretchedValid = false;
+
+    return true;
+}
+
 EST_RESULT EST_EncoderGetSample(EST_ENCODER_HANDLE handle, EST_DEVICE_HANDLE devhandle, EST_AUDIO_HANDLE *outSample)
 {
     auto decoder = reinterpret_cast<EST_Encoder *>(handle);
@@ -255,7 +763,20 @@ EST_RESULT EST_EncoderGetSample(EST_ENCODER_HANDLE handle, EST_DEVICE_HANDLE dev
         return EST_ERROR_INVALID_ARGUMENT;
     }
 
-    if (decoder->numOfPcmProcessed == 0) {
+    est_device_info deviceInfo = {};
+
+    auto infoResult = EST_GetInfo(devhandle, &deviceInfo);
+    if (infoResult != EST_OK) {
+        return infoResult;
+    }
+
+    // Rendered at the device rate the mixer plays the frames as they are
+    if (deviceInfo.sampleRate > 0 && !encoder_set_output_rate(decoder, static_cast<ma_uint32>(deviceInfo.sampleRate))) {
+        EST_EncoderSetError("Failed to change the render sample rate");
+        return EST_ERROR_INVALID_STATE;
+    }
+
+    if (!EncoderOutput(decoder)) {
         auto renderResult = EST_EncoderRender(handle);
         if (renderResult != EST_OK) {
             return renderResult;
@@ -263,11 +784,46 @@ EST_RESULT EST_EncoderGetSample(EST_ENCODER_HANDLE handle, EST_DEVICE_HANDLE dev
     }
 
     int maxChannels = decoder->channels;
+    int sampleRate = static_cast<int>(decoder->decoder.outputSampleRate);
 
-    auto result = EST_SampleLoadRawPCM(devhandle, decoder->data.data(), decoder->numOfPcmProcessed, maxChannels, 44100, outSample);
-    if (result != EST_OK) {
-        return result;
+    // A cached render is handed over as it is, the sample keeps the mapping alive
+    if (decoder->mapped) {
+        auto mapping = new (std::nothrow) std::shared_ptr<EST_MappedFile>(decoder->mapped);
+        if (!mapping) {
+            return EST_ERROR_OUT_OF_MEMORY;
+        }
+
+        auto release = [](void *, void *userData) {
+            delete static_cast<std::shared_ptr<EST_MappedFile> *>(userData);
+        };
+
+        return EST_SampleLoadRawPCMOwned(devhandle, const_cast<float *>(decoder->mappedFrames), decoder->numOfPcmProcessed, maxChannels, sampleRate, release, mapping, outSample);
     }
 
-    return EST_OK;
+    // The render moves into the sample, the encoder keeps reading the same frames
+    if (!decoder->handedOver) {
+        std::shared_ptr<const std::vector<float>> frames;
+
+        try {
+            frames = std::make_shared<const std::vector<float>>(std::move(decoder->data));
+        } catch (std::bad_alloc &) {
+            EST_EncoderSetError("Out of memory!");
+            return EST_ERROR_OUT_OF_MEMORY;
+        }
+
+        decoder->data = std::vector<float>();
+        decoder->handedOver = frames;
+        decoder->mappedFrames = frames->data();
+    }
+
+    auto owner = new (std::nothrow) std::shared_ptr<const std::vector<float>>(decoder->handedOver);
+    if (!owner) {
+        return EST_ERROR_OUT_OF_MEMORY;
+    }
+
+    auto release = [](void *, void *userData) {
+        delete static_cast<std::shared_ptr<const std::vector<float>> *>(userData);
+    };
+
+    return EST_SampleLoadRawPCMOwned(devhandle, const_cast<float *>(decoder->mappedFrames), decoder->numOfPcmProcessed, maxChannels, sampleRate, release, owner, outSample);
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "EncoderInternal.h"
+#include <atomic>
+#include <system_error>
+
+// Every attribute of the source encoder, then the ones the variant names in fields
+static EST_RESULT variant_configure(EST_Encoder *source, EST_ENCODER_HANDLE handle, const est_encoder_variant &variant)
+{
+    float volume = 1.0f;
+    ma_gainer_get_master_volume(&source->gainer, &volume);
+
+    const struct
+    {
+        enum EST_ATTRIBUTE_FLAGS attribute;
+        float                    value;
+    } attributes[] = {
+        { EST_ATTRIB_ENCODER_SAMPLERATE, source->sampleRate },
+        { EST_ATTRIB_ENCODER_QUALITY, source->exportQuality },
+        { EST_ATTRIB_ENCODER_TEMPO, (variant.fields & EST_VARIANT_TEMPO) ? variant.tempo : source->rate },
+        { EST_ATTRIB_ENCODER_PITCH, (variant.fields & EST_VARIANT_PITCH) ? variant.pitch : source->pitch },
+        { EST_ATTRIB_VOLUME, (variant.fields & EST_VARIANT_VOLUME) ? variant.volume : volume },
+        { EST_ATTRIB_PAN, (variant.fields & EST_VARIANT_PAN) ? variant.pan : ma_panner_get_pan(&source->panner) },
+    };
+
+    for (const auto &entry : attributes) {
+        EST_RESULT result = EST_EncoderSetAttribute(handle, entry.attribute, entry.value);
+        if (result != EST_OK) {
+            return result;
+        }
+    }
+
+    return EST_OK;
+}
+
+EST_RESULT EST_EncoderRenderVariants(EST_ENCODER_HANDLE handle, const est_encoder_variant *variants, int variantCount, EST_ENCODER_HANDLE *outputs)
+{
+    auto decoder = reinterpret_cast<EST_Encoder *>(handle);
+    if (!decoder || decoder->Signature != kESTEncoderSignature) {
+        EST_EncoderSetError("Invalid handle");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!variants || variantCount <= 0 || !outputs) {
+        EST_EncoderSetError("Invalid arguments");
+        return EST_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::fill(outputs, outputs + variantCount, nullptr);
+
+    auto release = [&] {
+        for (int i = 0; i < variantCount; i++) {
+            if (outputs[i]) {
+                EST_EncoderFree(outputs[i]);
+                outputs[i] = nullptr;
+            }
+        }
+    };
+
+    for (int i = 0; i < variantCount; i++) {
+        EST_RESULT result = EncoderClone(decoder, &outputs[i]);
+        if (result == EST_OK) {
+            result = variant_configure(decoder, outputs[i], variants[i]);
+        }
+
+        if (result != EST_OK) {
+            release();
+            return result;
+        }
+    }
+
+    // Decoded once here (or kept from an earlier render), every variant reads the same frames
+    EncoderDecodeSource(decoder);
+
+    for (int i = 0; i < variantCount; i++) {
+        auto variant = reinterpret_cast<EST_Encoder *>(outputs[i]);
+
+        variant->decodeThreads = 1; // Only used when the shared decode failed
+
+        // A variant with its own rate mod reads through its decoder instead
+        if (EncoderIsNativeRate(variant)) {
+            variant->decoded = decoder->decoded;
+            variant->decodedFrames = decoder->decodedFrames;
+        }
+    }
+
+    // Each variant runs its own resampler, stretcher and gain chain, one per core at most
+    unsigned int threads = std::min<unsigned int>(std::max(1u, std::thread::hardware_concurrency()), static_cast<unsigned int>(variantCount));
+
+    std::atomic<int>        next = { 0 };
+    std::vector<EST_RESULT> results(variantCount, EST_OK);
+
+    auto worker = [&] {
+        for (int i = next++; i < variantCount; i = next++) {
+            results[i] = EST_EncoderRender(outputs[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+
+    try {
+        pool.reserve(threads - 1);
+
+        for (unsigned int i = 1; i < threads; i++) {
+            pool.emplace_back(worker);
+        }
+    } catch (std::exception &) {
+        // Out of threads or memory, the ones running pick up the rest and are still joined below
+    }
+
+    worker();
+
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    for (EST_RESULT result : results) {
+        if (result != EST_OK) {
+            release();
+            EST_EncoderSetError("Failed to render variant");
+            return result;
+        }
+    }
+
+    return EST_OK;
+}
\ No newline at end of file
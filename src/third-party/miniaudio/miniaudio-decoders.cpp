@@ -49,7 +49,6 @@ ma_result ma_decoding_backend_init_file__libopus(void* pUserData, const char* pF
     return MA_SUCCESS;
 }
 
-
 ma_result ma_decoding_backend_init_memory__libopus(void* pUserData, const void* pData, size_t dataSize, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend)
 {
     ma_result result;
@@ -92,6 +91,11 @@ ma_result ma_decoding_backend_get_channel_map__libopus(void* pUserData, ma_data_
     return ma_libopus_get_data_format(pOpus, NULL, NULL, NULL, pChannelMap, channelMapCap);
 }
 
+ma_result ma_decoding_backend_bind_seek_index__libopus(ma_data_source* pBackend, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount)
+{
+    return ma_libopus_bind_seek_index((ma_libopus*)pBackend, pSeekPoints, seekPointCount);
+}
+
 ma_result ma_decoding_backend_init__libvorbis(void* pUserData, ma_read_proc onRead, ma_seek_proc onSeek, ma_tell_proc onTell, void* pReadSeekTellUserData, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend)
 {
     ma_result result;
@@ -138,27 +142,28 @@ ma_result ma_decoding_backend_init_file__libvorbis(void* pUserData, const char*
     return MA_SUCCESS;
 }
 
-//ma_result ma_decoding_backend_init_memory__libvorbis(void* pUserData, const void* pData, size_t dataSize, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend) {
-//    ma_result result;
-//    ma_libvorbis* pOpus;
-//
-//    (void)pUserData;
-//
-//    pOpus = (ma_libvorbis*)ma_malloc(sizeof(*pOpus), pAllocationCallbacks);
-//    if (pOpus == NULL) {
-//        return MA_OUT_OF_MEMORY;
-//    }
-//
-//    result = ma_libvorbis_init_memory(pData, dataSize, pConfig, pAllocationCallbacks, pOpus);
-//    if (result != MA_SUCCESS) {
-//        ma_free(pOpus, pAllocationCallbacks);
-//        return result;
-//    }
-//
-//    *ppBackend = pOpus;
-//
-//    return MA_SUCCESS;
-//}
+ma_result ma_decoding_backend_init_memory__libvorbis(void* pUserData, const void* pData, size_t dataSize, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend)
+{
+    ma_result result;
+    ma_libvorbis* pVorbis;
+
+    (void)pUserData;
+
+    pVorbis = (ma_libvorbis*)ma_malloc(sizeof(*pVorbis), pAllocationCallbacks);
+    if (pVorbis == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    result = ma_libvorbis_init_memory(pData, dataSize, pConfig, pAllocationCallbacks, pVorbis);
+    if (result != MA_SUCCESS) {
+        ma_free(pVorbis, pAllocationCallbacks);
+        return result;
+    }
+
+    *ppBackend = pVorbis;
+
+    return MA_SUCCESS;
+}
 
 void ma_decoding_backend_uninit__libvorbis(void* pUserData, ma_data_source* pBackend, const ma_allocation_callbacks* pAllocationCallbacks)
 {
@@ -179,3 +184,75 @@ ma_result ma_decoding_backend_get_channel_map__libvorbis(void* pUserData, ma_dat
     return ma_libvorbis_get_data_format(pVorbis, NULL, NULL, NULL, pChannelMap, channelMapCap);
 }
 
+ma_result ma_decoding_backend_bind_seek_index__libvorbis(ma_data_source* pBackend, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount)
+{
+    return ma_libvorbis_bind_seek_index((ma_libvorbis*)pBackend, pSeekPoints, seekPointCount);
+}
+
+ma_result ma_decoder_share_mp3_seek_table(const ma_decoder* pSource, ma_decoder* pDecoder)
+{
+    const ma_mp3* pSourceMP3;
+    ma_mp3* pMP3;
+
+    if (pSource == NULL || pDecoder == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    if (pSource->pBackendVTable != &g_ma_decoding_backend_vtable_mp3 || pDecoder->pBackendVTable != &g_ma_decoding_backend_vtable_mp3) {
+        return MA_INVALID_OPERATION;
+    }
+
+    pSourceMP3 = (const ma_mp3*)pSource->pBackend;
+    pMP3 = (ma_mp3*)pDecoder->pBackend;
+
+    if (pSourceMP3->pSeekPoints == NULL || pMP3->pSeekPoints != NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    /* Only the dr_mp3 side is bound, ma_mp3 keeps a NULL table and won't free the borrowed one */
+    if (!ma_dr_mp3_bind_seek_table(&pMP3->dr, pSourceMP3->seekPointCount, pSourceMP3->pSeekPoints)) {
+        return MA_ERROR;
+    }
+
+    return MA_SUCCESS;
+}
+
+ma_result ma_decoder_copy_mp3_seek_table(const ma_decoder* pSource, ma_decoder* pDecoder)
+{
+    const ma_mp3* pSourceMP3;
+    ma_mp3* pMP3;
+    ma_dr_mp3_seek_point* pSeekPoints;
+
+    if (pSource == NULL || pDecoder == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    if (pSource->pBackendVTable != &g_ma_decoding_backend_vtable_mp3 || pDecoder->pBackendVTable != &g_ma_decoding_backend_vtable_mp3) {
+        return MA_INVALID_OPERATION;
+    }
+
+    pSourceMP3 = (const ma_mp3*)pSource->pBackend;
+    pMP3 = (ma_mp3*)pDecoder->pBackend;
+
+    if (pSourceMP3->pSeekPoints == NULL || pMP3->pSeekPoints != NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    pSeekPoints = (ma_dr_mp3_seek_point*)ma_malloc(sizeof(*pSeekPoints) * pSourceMP3->seekPointCount, &pDecoder->allocationCallbacks);
+    if (pSeekPoints == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    MA_COPY_MEMORY(pSeekPoints, pSourceMP3->pSeekPoints, sizeof(*pSeekPoints) * pSourceMP3->seekPointCount);
+
+    if (!ma_dr_mp3_bind_seek_table(&pMP3->dr, pSourceMP3->seekPointCount, pSeekPoints)) {
+        ma_free(pSeekPoints, &pDecoder->allocationCallbacks);
+        return MA_ERROR;
+    }
+
+    /* Owned like a table built at init, ma_mp3_uninit frees it */
+    pMP3->seekPointCount = pSourceMP3->seekPointCount;
+    pMP3->pSeekPoints = pSeekPoints;
+
+    return MA_SUCCESS;
+}
@@ -5,6 +5,13 @@
 //#define MA_NO_RESOURCE_MANAGER
 #include "miniaudio.h"
 
+/* One entry of an Ogg page index, decoding from byteOffset never starts after pcmFrame */
+typedef struct
+{
+    ma_uint64 pcmFrame;   /* Granule position of the page before, in the stream's own units */
+    ma_uint64 byteOffset; /* Start of the page */
+} ma_ogg_seek_point;
+
 ma_result ma_decoding_backend_init__libopus(void* pUserData, ma_read_proc onRead, ma_seek_proc onSeek, ma_tell_proc onTell, void* pReadSeekTellUserData, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend);
 
 ma_result ma_decoding_backend_init_file__libopus(void* pUserData, const char* pFilePath, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend);
@@ -15,6 +22,9 @@ void ma_decoding_backend_uninit__libopus(void* pUserData, ma_data_source* pBacke
 
 ma_result ma_decoding_backend_get_channel_map__libopus(void* pUserData, ma_data_source* pBackend, ma_channel* pChannelMap, size_t channelMapCap);
 
+/* The points are referenced, not copied. They must outlive the backend or be unbound with a count of 0. */
+ma_result ma_decoding_backend_bind_seek_index__libopus(ma_data_source* pBackend, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount);
+
 ma_result ma_decoding_backend_init__libvorbis(void* pUserData, ma_read_proc onRead, ma_seek_proc onSeek, ma_tell_proc onTell, void* pReadSeekTellUserData, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend);
 
 ma_result ma_decoding_backend_init_file__libvorbis(void* pUserData, const char* pFilePath, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_data_source** ppBackend);
@@ -25,12 +35,20 @@ void ma_decoding_backend_uninit__libvorbis(void* pUserData, ma_data_source* pBac
 
 ma_result ma_decoding_backend_get_channel_map__libvorbis(void* pUserData, ma_data_source* pBackend, ma_channel* pChannelMap, size_t channelMapCap);
 
+ma_result ma_decoding_backend_bind_seek_index__libvorbis(ma_data_source* pBackend, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount);
+
+/* Points the MP3 backend of pDecoder at the seek table pSource built at init, nothing is copied. pSource must outlive pDecoder. */
+ma_result ma_decoder_share_mp3_seek_table(const ma_decoder* pSource, ma_decoder* pDecoder);
+
+/* Same, but pDecoder gets a copy it owns and frees on uninit, for decoders that can outlive pSource. */
+ma_result ma_decoder_copy_mp3_seek_table(const ma_decoder* pSource, ma_decoder* pDecoder);
+
 static ma_decoding_backend_vtable g_ma_decoding_backend_vtable_libvorbis =
 {
     ma_decoding_backend_init__libvorbis,
     ma_decoding_backend_init_file__libvorbis,
     NULL, /* onInitFileW() */
-    NULL, /* onInitMemory() */
+    ma_decoding_backend_init_memory__libvorbis,
     ma_decoding_backend_uninit__libvorbis
 };
 
@@ -39,7 +57,7 @@ static ma_decoding_backend_vtable g_ma_decoding_backend_vtable_libopus =
     ma_decoding_backend_init__libopus,
     ma_decoding_backend_init_file__libopus,
     NULL, /* onInitFileW() */
-    NULL, /* onInitMemory() */
+    ma_decoding_backend_init_memory__libopus,
     ma_decoding_backend_uninit__libopus
 };
 
@@ -24,6 +24,8 @@ extern "C" {
         ma_tell_proc onTell;
         void* pReadSeekTellUserData;
         ma_format format;           /* Will be either f32 or s16. */
+        const ma_ogg_seek_point* pSeekPoints; /* Optional page index, see ma_libopus_bind_seek_index(). */
+        ma_uint32 seekPointCount;
 #if !defined(MA_NO_LIBOPUS)
         OggOpusFile* of;
 #endif
@@ -35,6 +37,7 @@ extern "C" {
     MA_API void ma_libopus_uninit(ma_libopus* pOpus, const ma_allocation_callbacks* pAllocationCallbacks);
     MA_API ma_result ma_libopus_read_pcm_frames(ma_libopus* pOpus, void* pFramesOut, ma_uint64 frameCount, ma_uint64* pFramesRead);
     MA_API ma_result ma_libopus_seek_to_pcm_frame(ma_libopus* pOpus, ma_uint64 frameIndex);
+    MA_API ma_result ma_libopus_bind_seek_index(ma_libopus* pOpus, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount);
     MA_API ma_result ma_libopus_get_data_format(ma_libopus* pOpus, ma_format* pFormat, ma_uint32* pChannels, ma_uint32* pSampleRate, ma_channel* pChannelMap, size_t channelMapCap);
     MA_API ma_result ma_libopus_get_cursor_in_pcm_frames(ma_libopus* pOpus, ma_uint64* pCursor);
     MA_API ma_result ma_libopus_get_length_in_pcm_frames(ma_libopus* pOpus, ma_uint64* pLength);
@@ -408,6 +411,95 @@ MA_API ma_result ma_libopus_read_pcm_frames(ma_libopus* pOpus, void* pFramesOut,
 #endif
 }
 
+MA_API ma_result ma_libopus_bind_seek_index(ma_libopus* pOpus, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount)
+{
+    if (pOpus == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+#if !defined(MA_NO_LIBOPUS)
+    /* Granule positions of a chained stream restart per link, the index can't describe it. */
+    if (seekPointCount > 0 && op_link_count(pOpus->of) != 1) {
+        return MA_INVALID_OPERATION;
+    }
+#endif
+
+    pOpus->pSeekPoints = pSeekPoints;
+    pOpus->seekPointCount = (pSeekPoints != NULL) ? seekPointCount : 0;
+
+    return MA_SUCCESS;
+}
+
+#if !defined(MA_NO_LIBOPUS)
+/*
+Jumps to the indexed page before the target and decodes forward, instead of bisecting the stream.
+Anything unexpected returns an error so the caller can fall back to op_pcm_seek().
+*/
+static ma_result ma_libopus_seek_to_pcm_frame_indexed(ma_libopus* pOpus, ma_uint64 frameIndex)
+{
+    const ma_uint64 prerollFrames = 3840;   /* 80ms at 48kHz, what the decoder needs to converge after a jump. */
+    const OpusHead* pHead = op_head(pOpus->of, 0);
+    float skipped[4096];
+    int channels = op_channel_count(pOpus->of, 0);
+    ma_uint64 granule;
+    ma_uint32 lo = 0;
+    ma_uint32 hi = pOpus->seekPointCount;
+    ogg_int64_t position;
+
+    if (pHead == NULL || channels <= 0 || channels > (int)(sizeof(skipped) / sizeof(skipped[0]))) {
+        return MA_INVALID_OPERATION;
+    }
+
+    /* Page granules include the pre-skip, op_pcm_tell() doesn't. */
+    granule = frameIndex + pHead->pre_skip;
+    if (granule < prerollFrames) {
+        return MA_INVALID_OPERATION;
+    }
+
+    while (lo < hi) {
+        ma_uint32 mid = lo + (hi - lo) / 2;
+        if (pOpus->pSeekPoints[mid].pcmFrame <= granule - prerollFrames) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) {
+        return MA_INVALID_OPERATION;
+    }
+
+    if (op_raw_seek(pOpus->of, (opus_int64)pOpus->pSeekPoints[lo - 1].byteOffset) != 0) {
+        return MA_ERROR;
+    }
+
+    position = op_pcm_tell(pOpus->of);
+    if (position < 0 || (ma_uint64)position > frameIndex) {
+        return MA_ERROR;
+    }
+
+    while ((ma_uint64)position < frameIndex) {
+        ma_uint64 framesRemaining = frameIndex - (ma_uint64)position;
+        ma_uint64 framesToSkip = sizeof(skipped) / sizeof(skipped[0]) / channels;
+        int framesSkipped;
+
+        if (framesToSkip > framesRemaining) {
+            framesToSkip = framesRemaining;
+        }
+
+        framesSkipped = op_read_float(pOpus->of, skipped, (int)(framesToSkip * channels), NULL);
+        if (framesSkipped <= 0) {
+            return MA_ERROR;
+        }
+
+        position += framesSkipped;
+    }
+
+    return MA_SUCCESS;
+}
+#endif
+
 MA_API ma_result ma_libopus_seek_to_pcm_frame(ma_libopus* pOpus, ma_uint64 frameIndex)
 {
     if (pOpus == NULL) {
@@ -416,7 +508,13 @@ MA_API ma_result ma_libopus_seek_to_pcm_frame(ma_libopus* pOpus, ma_uint64 frame
 
 #if !defined(MA_NO_LIBOPUS)
     {
-        int libopusResult = op_pcm_seek(pOpus->of, (ogg_int64_t)frameIndex);
+        int libopusResult;
+
+        if (pOpus->seekPointCount > 0 && ma_libopus_seek_to_pcm_frame_indexed(pOpus, frameIndex) == MA_SUCCESS) {
+            return MA_SUCCESS;
+        }
+
+        libopusResult = op_pcm_seek(pOpus->of, (ogg_int64_t)frameIndex);
         if (libopusResult != 0) {
             if (libopusResult == OP_ENOSEEK) {
                 return MA_INVALID_OPERATION;    /* Not seekable. */
@@ -27,6 +27,11 @@ extern "C" {
         ma_tell_proc onTell;
         void* pReadSeekTellUserData;
         ma_format format;           /* Will be either f32 or s16. */
+        const unsigned char* pMemory;   /* Set when decoding straight from a memory block. */
+        size_t memorySize;
+        size_t memoryCursor;
+        const ma_ogg_seek_point* pSeekPoints; /* Optional page index, see ma_libvorbis_bind_seek_index(). */
+        ma_uint32 seekPointCount;
 #if !defined(MA_NO_LIBVORBIS)
         OggVorbis_File vf;
 #endif
@@ -34,9 +39,11 @@ extern "C" {
 
     MA_API ma_result ma_libvorbis_init(ma_read_proc onRead, ma_seek_proc onSeek, ma_tell_proc onTell, void* pReadSeekTellUserData, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_libvorbis* pVorbis);
     MA_API ma_result ma_libvorbis_init_file(const char* pFilePath, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_libvorbis* pVorbis);
+    MA_API ma_result ma_libvorbis_init_memory(const void* pData, size_t dataSize, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_libvorbis* pVorbis);
     MA_API void ma_libvorbis_uninit(ma_libvorbis* pVorbis, const ma_allocation_callbacks* pAllocationCallbacks);
     MA_API ma_result ma_libvorbis_read_pcm_frames(ma_libvorbis* pVorbis, void* pFramesOut, ma_uint64 frameCount, ma_uint64* pFramesRead);
     MA_API ma_result ma_libvorbis_seek_to_pcm_frame(ma_libvorbis* pVorbis, ma_uint64 frameIndex);
+    MA_API ma_result ma_libvorbis_bind_seek_index(ma_libvorbis* pVorbis, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount);
     MA_API ma_result ma_libvorbis_get_data_format(ma_libvorbis* pVorbis, ma_format* pFormat, ma_uint32* pChannels, ma_uint32* pSampleRate, ma_channel* pChannelMap, size_t channelMapCap);
     MA_API ma_result ma_libvorbis_get_cursor_in_pcm_frames(ma_libvorbis* pVorbis, ma_uint64* pCursor);
     MA_API ma_result ma_libvorbis_get_length_in_pcm_frames(ma_libvorbis* pVorbis, ma_uint64* pLength);
@@ -143,6 +150,60 @@ static long ma_libvorbis_vf_callback__tell(void* pUserData)
 
     return (long)cursor;
 }
+
+/* Memory callbacks read the block directly, without going through miniaudio's read/seek/tell abstraction. */
+static size_t ma_libvorbis_vf_callback__read_memory(void* pBufferOut, size_t size, size_t count, void* pUserData)
+{
+    ma_libvorbis* pVorbis = (ma_libvorbis*)pUserData;
+    size_t bytesToRead;
+    size_t bytesRemaining;
+
+    if (size == 0 || count == 0) {
+        return 0;
+    }
+
+    bytesRemaining = pVorbis->memorySize - pVorbis->memoryCursor;
+    bytesToRead = size * count;
+    if (bytesToRead > bytesRemaining) {
+        bytesToRead = bytesRemaining - (bytesRemaining % size);
+    }
+
+    MA_COPY_MEMORY(pBufferOut, pVorbis->pMemory + pVorbis->memoryCursor, bytesToRead);
+    pVorbis->memoryCursor += bytesToRead;
+
+    return bytesToRead / size;
+}
+
+static int ma_libvorbis_vf_callback__seek_memory(void* pUserData, ogg_int64_t offset, int whence)
+{
+    ma_libvorbis* pVorbis = (ma_libvorbis*)pUserData;
+    ogg_int64_t base;
+
+    if (whence == SEEK_SET) {
+        base = 0;
+    }
+    else if (whence == SEEK_END) {
+        base = (ogg_int64_t)pVorbis->memorySize;
+    }
+    else {
+        base = (ogg_int64_t)pVorbis->memoryCursor;
+    }
+
+    if (base + offset < 0 || base + offset > (ogg_int64_t)pVorbis->memorySize) {
+        return -1;
+    }
+
+    pVorbis->memoryCursor = (size_t)(base + offset);
+
+    return 0;
+}
+
+static long ma_libvorbis_vf_callback__tell_memory(void* pUserData)
+{
+    ma_libvorbis* pVorbis = (ma_libvorbis*)pUserData;
+
+    return (long)pVorbis->memoryCursor;
+}
 #endif
 
 static ma_result ma_libvorbis_init_internal(const ma_decoding_backend_config* pConfig, ma_libvorbis* pVorbis)
@@ -252,6 +313,51 @@ MA_API ma_result ma_libvorbis_init_file(const char* pFilePath, const ma_decoding
 #endif
 }
 
+MA_API ma_result ma_libvorbis_init_memory(const void* pData, size_t dataSize, const ma_decoding_backend_config* pConfig, const ma_allocation_callbacks* pAllocationCallbacks, ma_libvorbis* pVorbis)
+{
+    ma_result result;
+
+    (void)pAllocationCallbacks; /* Can't seem to find a way to configure memory allocations in libvorbis. */
+
+    result = ma_libvorbis_init_internal(pConfig, pVorbis);
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    if (pData == NULL || dataSize == 0) {
+        return MA_INVALID_ARGS;
+    }
+
+    /* The block is referenced, not copied. It must outlive the decoder. */
+    pVorbis->pMemory = (const unsigned char*)pData;
+    pVorbis->memorySize = dataSize;
+    pVorbis->memoryCursor = 0;
+
+#if !defined(MA_NO_LIBVORBIS)
+    {
+        int libvorbisResult;
+        ov_callbacks libvorbisCallbacks;
+
+        libvorbisCallbacks.read_func = ma_libvorbis_vf_callback__read_memory;
+        libvorbisCallbacks.seek_func = ma_libvorbis_vf_callback__seek_memory;
+        libvorbisCallbacks.close_func = NULL;
+        libvorbisCallbacks.tell_func = ma_libvorbis_vf_callback__tell_memory;
+
+        libvorbisResult = ov_open_callbacks(pVorbis, &pVorbis->vf, NULL, 0, libvorbisCallbacks);
+        if (libvorbisResult < 0) {
+            return MA_INVALID_FILE;
+        }
+
+        return MA_SUCCESS;
+    }
+#else
+    {
+        /* libvorbis is disabled. */
+        return MA_NOT_IMPLEMENTED;
+    }
+#endif
+}
+
 MA_API void ma_libvorbis_uninit(ma_libvorbis* pVorbis, const ma_allocation_callbacks* pAllocationCallbacks)
 {
     if (pVorbis == NULL) {
@@ -371,6 +477,82 @@ MA_API ma_result ma_libvorbis_read_pcm_frames(ma_libvorbis* pVorbis, void* pFram
 #endif
 }
 
+MA_API ma_result ma_libvorbis_bind_seek_index(ma_libvorbis* pVorbis, const ma_ogg_seek_point* pSeekPoints, ma_uint32 seekPointCount)
+{
+    if (pVorbis == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+#if !defined(MA_NO_LIBVORBIS)
+    /* Granule positions of a chained stream restart per link, the index can't describe it. */
+    if (seekPointCount > 0 && ov_streams(&pVorbis->vf) != 1) {
+        return MA_INVALID_OPERATION;
+    }
+#endif
+
+    pVorbis->pSeekPoints = pSeekPoints;
+    pVorbis->seekPointCount = (pSeekPoints != NULL) ? seekPointCount : 0;
+
+    return MA_SUCCESS;
+}
+
+#if !defined(MA_NO_LIBVORBIS)
+/*
+Jumps to the indexed page before the target and decodes forward, instead of bisecting the stream.
+Anything unexpected returns an error so the caller can fall back to ov_pcm_seek().
+*/
+static ma_result ma_libvorbis_seek_to_pcm_frame_indexed(ma_libvorbis* pVorbis, ma_uint64 frameIndex)
+{
+    const ma_uint64 lapFrames = 4096;   /* Half the largest Vorbis block, a page may start mid-packet. */
+    ma_uint32 lo = 0;
+    ma_uint32 hi = pVorbis->seekPointCount;
+    ogg_int64_t position;
+
+    if (frameIndex < lapFrames) {
+        return MA_INVALID_OPERATION;
+    }
+
+    /* Last point whose page starts decoding at least lapFrames before the target. */
+    while (lo < hi) {
+        ma_uint32 mid = lo + (hi - lo) / 2;
+        if (pVorbis->pSeekPoints[mid].pcmFrame <= frameIndex - lapFrames) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) {
+        return MA_INVALID_OPERATION;
+    }
+
+    if (ov_raw_seek(&pVorbis->vf, (ogg_int64_t)pVorbis->pSeekPoints[lo - 1].byteOffset) != 0) {
+        return MA_ERROR;
+    }
+
+    position = ov_pcm_tell(&pVorbis->vf);
+    if (position < 0 || (ma_uint64)position > frameIndex) {
+        return MA_ERROR;
+    }
+
+    while ((ma_uint64)position < frameIndex) {
+        float** ppFrames;
+        ma_uint64 framesRemaining = frameIndex - (ma_uint64)position;
+        int framesToSkip = (framesRemaining > 4096) ? 4096 : (int)framesRemaining;
+        long framesSkipped = ov_read_float(&pVorbis->vf, &ppFrames, framesToSkip, NULL);
+
+        if (framesSkipped <= 0) {
+            return MA_ERROR;
+        }
+
+        position += framesSkipped;
+    }
+
+    return MA_SUCCESS;
+}
+#endif
+
 MA_API ma_result ma_libvorbis_seek_to_pcm_frame(ma_libvorbis* pVorbis, ma_uint64 frameIndex)
 {
     if (pVorbis == NULL) {
@@ -379,7 +561,13 @@ MA_API ma_result ma_libvorbis_seek_to_pcm_frame(ma_libvorbis* pVorbis, ma_uint64
 
 #if !defined(MA_NO_LIBVORBIS)
     {
-        int libvorbisResult = ov_pcm_seek(&pVorbis->vf, (ogg_int64_t)frameIndex);
+        int libvorbisResult;
+
+        if (pVorbis->seekPointCount > 0 && ma_libvorbis_seek_to_pcm_frame_indexed(pVorbis, frameIndex) == MA_SUCCESS) {
+            return MA_SUCCESS;
+        }
+
+        libvorbisResult = ov_pcm_seek(&pVorbis->vf, (ogg_int64_t)frameIndex);
         if (libvorbisResult != 0) {
             if (libvorbisResult == OV_ENOSEEK) {
                 return MA_INVALID_OPERATION;    /* Not seekable. */
@@ -0,0 +1,95 @@
+#include "EstAudio.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Builds a sound bank from every audio file under a directory, sounds are named by
+// their path relative to it with '/' separators, e.g. "hitsounds/normal-hitclap.wav"
+static void usage()
+{
+    printf("Usage: EstBank <directory> <output> [--decoded] [--rate <sampleRate>] [--channels <channels>]\n");
+}
+
+static bool is_audio_file(const std::filesystem::path &path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+
+    return extension == ".wav" || extension == ".flac" || extension == ".mp3" || extension == ".ogg" || extension == ".opus";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    int            sampleRate = 0;
+    int            channels = 0;
+    EST_BANK_FLAGS flags = EST_BANK_DEFAULT;
+
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--decoded") == 0) {
+            flags = EST_BANK_DECODED;
+        } else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            sampleRate = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--channels") == 0 && i + 1 < argc) {
+            channels = std::atoi(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::filesystem::path    root(argv[1]);
+    std::vector<std::string> paths;
+    std::vector<std::string> names;
+    std::error_code          error;
+
+    for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file() && is_audio_file(it->path())) {
+            paths.push_back(it->path().string());
+        }
+    }
+
+    if (error) {
+        printf("Failed to read directory %s\n", argv[1]);
+        return 1;
+    }
+
+    if (paths.empty()) {
+        printf("No audio files in %s\n", argv[1]);
+        return 1;
+    }
+
+    // Same input, same bank
+    std::sort(paths.begin(), paths.end());
+
+    for (const auto &path : paths) {
+        names.push_back(std::filesystem::path(path).lexically_relative(root).generic_string());
+    }
+
+    std::vector<est_bank_entry> entries(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        entries[i].path = paths[i].c_str();
+        entries[i].name = names[i].c_str();
+        entries[i].loopStart = 0;
+        entries[i].loopEnd = 0;
+    }
+
+    if (EST_BankBuild(entries.data(), static_cast<int>(entries.size()), sampleRate, channels, flags, argv[2]) != EST_OK) {
+        printf("Failed to build bank %s\n", EST_GetError());
+        return 1;
+    }
+
+    printf("Packed %d sounds into %s\n", static_cast<int>(entries.size()), argv[2]);
+    return 0;
+}
\ No newline at end of file